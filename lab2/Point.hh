@@ -1,3 +1,6 @@
+#ifndef POINT_HH
+#define POINT_HH
+
 // A 3-dimensional point class!
 // Coordinates are double-precision floating point.
 class Point {
@@ -28,3 +31,5 @@ public:
   // Other methods
   double distanceTo(const Point &p) const;
 };
+
+#endif // POINT_HH
@@ -0,0 +1,72 @@
+#include "ThreadPool.hh"
+#include <algorithm>
+
+
+// Starts >numThreads< workers, or one per hardware thread if it is 0.
+ThreadPool::ThreadPool(unsigned int numThreads) : running(0), stopping(false) {
+    if (numThreads == 0)
+        numThreads = std::max(1u, thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < numThreads; i++)
+        this->workers.push_back(thread(&ThreadPool::workerLoop, this));
+}
+
+
+// Lets the workers drain the queue, then stops and joins them.
+ThreadPool::~ThreadPool() {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->hasWork.notify_all();
+    for (thread &t : this->workers)
+        t.join();
+}
+
+
+// Gets the number of worker threads.
+unsigned int ThreadPool::size() const {
+    return this->workers.size();
+}
+
+
+// Queues a task to be run on one of the workers.
+void ThreadPool::submit(function<void()> task) {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->tasks.push(task);
+    }
+    this->hasWork.notify_one();
+}
+
+
+// Blocks until every submitted task has finished running.
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(this->lock);
+    while (!this->tasks.empty() || this->running > 0)
+        this->finished.wait(guard);
+}
+
+
+// Body of each worker: take tasks off the queue until the pool stops.
+void ThreadPool::workerLoop() {
+    unique_lock<mutex> guard(this->lock);
+    for (;;) {
+        while (this->tasks.empty() && !this->stopping)
+            this->hasWork.wait(guard);
+        if (this->tasks.empty())
+            return;     // stopping, and nothing left to do
+
+        function<void()> task = this->tasks.front();
+        this->tasks.pop();
+        this->running++;
+
+        guard.unlock();
+        task();
+        guard.lock();
+
+        this->running--;
+        if (this->tasks.empty() && this->running == 0)
+            this->finished.notify_all();
+    }
+}
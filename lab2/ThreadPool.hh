@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_HH
+#define THREAD_POOL_HH
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+// A fixed set of worker threads that run submitted tasks. The threads are
+// started once in the constructor and live until the pool is destroyed, so
+// handing work to the pool never pays for creating a thread.
+class ThreadPool {
+
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex lock;
+    condition_variable hasWork;     // signalled when a task is queued
+    condition_variable finished;    // signalled when the pool goes idle
+    unsigned int running;           // tasks currently being run
+    bool stopping;
+
+    void workerLoop();
+
+public:
+    // Constructors. Passing 0 starts one thread per hardware thread.
+    ThreadPool(unsigned int numThreads = 0);
+
+    // Destructor - waits for queued tasks, then joins the threads.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Accessor methods
+    unsigned int size() const;
+
+    // Other methods
+    void submit(function<void()> task);
+    void wait();
+};
+
+
+#endif // THREAD_POOL_HH
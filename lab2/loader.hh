@@ -0,0 +1,62 @@
+#ifndef LOADER_HH
+#define LOADER_HH
+
+#include "Point.hh"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Header of the binary point format. It is followed by the coordinates
+// stored one dimension at a time: all x values, then all y values, and so
+// on, each as a little-endian double. The header is 16 bytes, so the
+// coordinate arrays of a mapped file are suitably aligned.
+struct BinaryPointsHeader {
+    char magic[4];          // "PTS1"
+    uint32_t dimension;     // 1 to 3 coordinates per point
+    uint64_t count;         // number of points
+};
+
+// A binary point file mapped into memory. The coordinates are used in
+// place (structure-of-arrays), so opening a file costs no parsing and no
+// copying until the points are converted to Point objects.
+class MappedPoints {
+
+private:
+    void *base;
+    size_t mappedBytes;
+    const BinaryPointsHeader *header;
+
+public:
+    // Constructors
+    MappedPoints();
+
+    // Destructor - unmaps the file.
+    ~MappedPoints();
+
+    MappedPoints(const MappedPoints &) = delete;
+    MappedPoints &operator=(const MappedPoints &) = delete;
+
+    // Maps >file<; returns false if it is missing or not a valid point file.
+    bool open(const string &file);
+    void close();
+
+    // Accessor methods
+    size_t size() const;
+    unsigned int dimension() const;
+    const double *coords(unsigned int dim) const;
+
+    // Other methods
+    Point point(size_t i) const;
+    void toVector(vector<Point> &points) const;
+};
+
+bool loadTextPoints(const string &file, vector<Point> &points);
+bool loadBinaryPoints(const string &file, vector<Point> &points);
+bool loadPoints(const string &file, vector<Point> &points);
+bool writeBinaryPoints(const string &file, const vector<Point> &points);
+
+
+#endif // LOADER_HH
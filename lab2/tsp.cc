@@ -1,13 +1,38 @@
 // @mattlim
 
-#include "Point.hh"
+#include "DistanceMatrix.hh"
+#include "batch.hh"
+#include "loader.hh"
 #include <algorithm>
-#include <climits>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <numeric>
+#include <string>
+#include <thread>
 #include <vector>
 using namespace std;
 
+// Counters reported by findShortestPathBranchAndBound.
+struct SearchStats {
+    unsigned long long nodesExpanded;   // partial tours that were extended
+    unsigned long long nodesPruned;     // partial tours cut off by the bound
+    SearchStats() : nodesExpanded(0), nodesPruned(0) {}
+};
+
+// Largest instance findShortestPathHeldKarp will accept. The DP table holds
+// 2^(n - 1) * (n - 1) entries of 5 bytes each, so 25 points is about 2 GB.
+const unsigned int HELD_KARP_MAX_POINTS = 25;
+
+// Largest instance the brute-force solvers take in batch mode, where one
+// big file would hold up the whole batch. 15 random points take seconds;
+// every point more multiplies that by about ten.
+const unsigned int BRUTE_FORCE_BATCH_MAX_POINTS = 15;
+
 /*
  * Takes
  * - a vector of points
@@ -29,6 +54,133 @@ double circuitLength(const vector<Point> &points, const vector<int> &order) {
     return length;
 }
 
+/*
+ * Same as above, but looks the distances up in a precomputed matrix instead
+ * of calling Point::distanceTo on every edge.
+ */
+double circuitLength(const DistanceMatrix &dist, const vector<int> &order) {
+    double length = 0;
+    for (unsigned int i = 0; i < order.size(); i++) {
+        int next;
+        if (i == order.size() - 1)
+            next = 0;
+        else
+            next = i + 1;
+
+        length += dist(order[i], order[next]);
+    }
+    return length;
+}
+
+/*
+ * Lowers a shared best-so-far length to >length< if it is shorter.
+ */
+static void updateSharedBest(atomic<double> &best, double length) {
+    double current = best.load();
+    while (length < current && !best.compare_exchange_weak(current, length))
+        ;
+}
+
+/*
+ * State for the exhaustive search behind findShortestPath and
+ * findShortestPathParallel.
+ *
+ * Tours are enumerated depth first with city 0 fixed in position 0, so each
+ * tour is only generated once rather than once per rotation. Of each tour
+ * and its mirror image, only the one whose second city is smaller than its
+ * last city is kept. prefix[k] holds the length of the path order[0 .. k],
+ * so moving to the next tour only costs the edges of the suffix that
+ * changed, and the closing edge is added at the leaves.
+ *
+ * prefix[] is accumulated edge by edge from city 0, in exactly the order
+ * circuitLength() sums a tour, and the matrix holds the same doubles
+ * Point::distanceTo returns, so the lengths compared here are the same
+ * doubles circuitLength() would produce. Because lengths only grow, any
+ * prefix that is already longer than the best tour is skipped.
+ */
+struct Enumeration {
+    unsigned int n;
+    const DistanceMatrix &dist;
+    vector<int> order;              // current partial tour, order[0] = 0
+    vector<bool> used;
+    vector<double> prefix;          // prefix[k] = length of order[0 .. k]
+    vector<int> forced;             // cities forced at positions 1, 2, ...
+    int largerLeft;                 // unused cities greater than order[1]
+
+    vector<int> bestOrder;
+    double bestLength;
+    atomic<double> *sharedBest;     // best length over all threads, or null
+
+    Enumeration(const DistanceMatrix &dist) : n(dist.size()), dist(dist) {
+        order.assign(n, 0);
+        used.assign(n, false);
+        used[0] = true;
+        prefix.assign(n, 0);
+        largerLeft = 0;
+        bestLength = numeric_limits<double>::infinity();
+        sharedBest = nullptr;
+    }
+
+    double d(int i, int j) const {
+        return dist(i, j);
+    }
+
+    // Enumerates every canonical completion of order[0 .. pos - 1].
+    void search(unsigned int pos) {
+        if (pos <= forced.size()) {
+            tryCity(pos, forced[pos - 1]);
+            return;
+        }
+        for (unsigned int c = 1; c < n; c++) {
+            if (!used[c])
+                tryCity(pos, c);
+        }
+    }
+
+    // Places city >c< at position >pos< if that can still lead to a
+    // canonical tour shorter than the best one, and recurses.
+    void tryCity(unsigned int pos, int c) {
+        bool last = pos == n - 1;
+        if (last && c < order[1])
+            return;     // mirror image of a tour we already enumerate
+
+        double length = prefix[pos - 1] + d(order[pos - 1], c);
+        double bound = bestLength;
+        if (sharedBest)
+            bound = std::min(bound, sharedBest->load(memory_order_relaxed));
+        if (length > bound)
+            return;
+
+        order[pos] = c;
+        if (last) {
+            double total = length + d(c, 0);
+            if (total < bestLength) {
+                bestLength = total;
+                bestOrder = order;
+                if (sharedBest)
+                    updateSharedBest(*sharedBest, total);
+            }
+            return;
+        }
+
+        // The last city has to be larger than order[1]; stop as soon as
+        // none of those are left.
+        int savedLarger = largerLeft;
+        if (pos == 1)
+            largerLeft = n - 1 - c;
+        else if (c > order[1])
+            largerLeft--;
+
+        if (largerLeft > 0) {
+            used[c] = true;
+            prefix[pos] = length;
+            search(pos + 1);
+            used[c] = false;
+        }
+        largerLeft = savedLarger;
+    }
+};
+
 /*
  * Solves the TSP by brute force.
  *
@@ -36,46 +188,627 @@ double circuitLength(const vector<Point> &points, const vector<int> &order) {
  * - a vector of points
  * and returns a vector that specifies the order to visit all the points in a
  * single round trip, visiting each point once, to ensure that the trip is
- * as short as possible.
+ * as short as possible. The order always starts with city 0. Of several
+ * shortest tours, the lexicographically smallest canonical one is returned.
  */
 vector<int> findShortestPath(const vector<Point> &points) {
-    double shortestLength = INT_MAX;
-    vector<int> orderPerm(points.size());
+    vector<int> shortestPath(points.size());
     // Initialize to 0, 1, 2, ..., N - 1
-    std::iota(orderPerm.begin(), orderPerm.end(), 0);
-    vector<int> shortestPath = orderPerm;
+    std::iota(shortestPath.begin(), shortestPath.end(), 0);
+    if (points.size() < 3)
+        return shortestPath;
+
+    DistanceMatrix dist(points);
+    Enumeration e(dist);
+    e.search(1);
+    // Only lengths that never compare below infinity (NaN) leave no tour.
+    if (e.bestOrder.empty())
+        return shortestPath;
+    return e.bestOrder;
+}
+
+/*
+ * Solves the TSP by brute force on several threads.
+ *
+ * The search space of findShortestPath is split by the two cities that
+ * follow city 0. Each such prefix is a task, and worker threads pull tasks
+ * off a shared counter. The shortest length seen so far is shared between
+ * workers, so a prefix that is already longer than it is skipped.
+ *
+ * Ties are broken in favour of the earliest prefix, which is also the order
+ * findShortestPath visits them in, so the result is exactly the order
+ * findShortestPath returns. Passing 0 for >numThreads< uses one thread per
+ * hardware thread.
+ */
+vector<int> findShortestPathParallel(const vector<Point> &points,
+                                     unsigned int numThreads) {
+    unsigned int n = points.size();
+    if (n < 4)
+        return findShortestPath(points);
+
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Prefixes (a, b) with a != b, in lexicographic order.
+    vector<pair<int, int>> prefixes;
+    for (unsigned int a = 1; a < n; a++) {
+        for (unsigned int b = 1; b < n; b++) {
+            if (a != b)
+                prefixes.push_back(make_pair(a, b));
+        }
+    }
+
+    const double NO_TOUR = numeric_limits<double>::infinity();
+    vector<double> taskLength(prefixes.size(), NO_TOUR);
+    vector<vector<int>> taskPath(prefixes.size());
+    atomic<unsigned int> nextTask(0);
+    atomic<double> sharedBest(NO_TOUR);
+    DistanceMatrix dist(points);
+
+    auto worker = [&]() {
+        Enumeration e(dist);
+        e.sharedBest = &sharedBest;
+        e.forced.resize(2);
+        for (;;) {
+            unsigned int t = nextTask++;
+            if (t >= prefixes.size())
+                return;
+
+            e.forced[0] = prefixes[t].first;
+            e.forced[1] = prefixes[t].second;
+            e.bestLength = NO_TOUR;
+            e.bestOrder.clear();
+            e.search(1);
+            if (!e.bestOrder.empty()) {
+                taskLength[t] = e.bestLength;
+                taskPath[t] = e.bestOrder;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned int i = 0; i < numThreads; i++)
+        threads.push_back(thread(worker));
+    for (thread &t : threads)
+        t.join();
+
+    // Same strict comparison as the serial search, in the same task order.
+    unsigned int best = 0;
+    for (unsigned int t = 1; t < prefixes.size(); t++) {
+        if (taskLength[t] < taskLength[best])
+            best = t;
+    }
+    if (taskPath[best].empty()) {
+        // As in findShortestPath, only NaN lengths leave no tour.
+        vector<int> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        return order;
+    }
+    return taskPath[best];
+}
+
+/*
+ * Solves the TSP exactly with the Held-Karp dynamic program.
+ *
+ * City 0 is fixed as the start of the tour. For every subset S of the other
+ * cities and every j in S, the table holds the length of the shortest path
+ * that leaves city 0, visits exactly the cities in S and ends at j. Subsets
+ * are bitmasks, so every subset is processed after all of its own subsets
+ * simply by counting upwards. This takes O(2^n * n^2) time instead of O(n!).
+ *
+ * To keep the table small, costs are stored as floats and the predecessor of
+ * each entry as a single byte. The returned order starts with city 0; its
+ * exact length should be recomputed with circuitLength().
+ */
+vector<int> findShortestPathHeldKarp(const vector<Point> &points) {
+    unsigned int n = points.size();
+    assert(n <= HELD_KARP_MAX_POINTS);
+
+    vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (n <= 3)
+        return order;
+
+    // Cities 1 .. n - 1 become bits 0 .. m - 1 of the subset masks.
+    unsigned int m = n - 1;
+    uint32_t full = (1u << m) - 1;
+    const uint8_t FROM_START = 0xff;
+
+    // Bit i stands for city i + 1 in the distance matrix.
+    FloatDistanceMatrix dist(points);
+    const float *fromStart = dist.row(0) + 1;
+
+    // cost[mask * m + j] and parent[mask * m + j] are only meaningful when
+    // bit j is set in mask.
+    size_t tableSize = ((size_t) full + 1) * m;
+    vector<float> cost(tableSize);
+    vector<uint8_t> parent(tableSize);
+
+    for (uint32_t mask = 1; mask <= full; mask++) {
+        float *row = &cost[(size_t) mask * m];
+        uint8_t *parentRow = &parent[(size_t) mask * m];
+
+        for (uint32_t ends = mask; ends != 0; ends &= ends - 1) {
+            unsigned int j = __builtin_ctz(ends);
+            uint32_t prev = mask ^ (1u << j);
+
+            if (prev == 0) {
+                row[j] = fromStart[j];
+                parentRow[j] = FROM_START;
+                continue;
+            }
+
+            const float *prevRow = &cost[(size_t) prev * m];
+            const float *toJ = dist.row(j + 1) + 1;
+            float best = INFINITY;
+            uint8_t bestK = 0;
+            for (uint32_t ks = prev; ks != 0; ks &= ks - 1) {
+                unsigned int k = __builtin_ctz(ks);
+                float c = prevRow[k] + toJ[k];
+                if (c < best) {
+                    best = c;
+                    bestK = k;
+                }
+            }
+            row[j] = best;
+            parentRow[j] = bestK;
+        }
+    }
+
+    // Close the tour back to city 0 from the best final city.
+    const float *fullRow = &cost[(size_t) full * m];
+    float best = INFINITY;
+    unsigned int last = 0;
+    for (unsigned int j = 0; j < m; j++) {
+        float c = fullRow[j] + fromStart[j];
+        if (c < best) {
+            best = c;
+            last = j;
+        }
+    }
 
-    do {
-        double permLength = circuitLength(points, orderPerm);
-        if (permLength < shortestLength) {
-            shortestPath = orderPerm;
-            shortestLength = permLength;
+    // Walk the parent pointers backwards to recover the visit order.
+    uint32_t mask = full;
+    unsigned int j = last;
+    for (unsigned int pos = n - 1; pos >= 1; pos--) {
+        order[pos] = j + 1;
+        uint8_t k = parent[(size_t) mask * m + j];
+        mask ^= 1u << j;
+        if (k == FROM_START) {
+            assert(pos == 1 && mask == 0);
+            break;
         }
+        j = k;
     }
-    while (std::next_permutation(orderPerm.begin(), orderPerm.end()));
 
-    return shortestPath;
+    return order;
 }
 
-int main() {
-    unsigned int num_points;
-    cout << "How many points? ";
-    cin >> num_points;
+/*
+ * Builds a tour by starting at city 0 and always moving to the nearest
+ * city that has not been visited yet.
+ */
+vector<int> nearestNeighbourTour(const vector<Point> &points) {
+    unsigned int n = points.size();
+    vector<int> order;
+    vector<bool> visited(n, false);
+    if (n == 0)
+        return order;
 
-    vector<Point> points(num_points);
-    double x, y, z;
-    for (unsigned int i = 0; i < num_points; i++) {
-        cout << "Point " << i << ": ";
-        cin >> x >> y >> z;
-        Point p(x, y, z);
-        points[i] = p;
+    int current = 0;
+    visited[0] = true;
+    order.push_back(0);
+    while (order.size() < n) {
+        int next = -1;
+        double nextDist = 0;
+        for (unsigned int c = 0; c < n; c++) {
+            if (visited[c])
+                continue;
+            double d = points[current].distanceTo(points[c]);
+            if (next < 0 || d < nextDist) {
+                next = c;
+                nextDist = d;
+            }
+        }
+        visited[next] = true;
+        order.push_back(next);
+        current = next;
     }
+    return order;
+}
+
+/*
+ * Improves a tour in place with 2-opt moves (reversing the segment between
+ * two edges whenever that shortens the tour) until no move helps.
+ */
+void improveTwoOpt(const vector<Point> &points, vector<int> &order) {
+    unsigned int n = order.size();
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (unsigned int i = 0; i + 2 < n; i++) {
+            for (unsigned int j = i + 2; j < n; j++) {
+                const Point &a = points[order[i]];
+                const Point &b = points[order[i + 1]];
+                const Point &c = points[order[j]];
+                const Point &d = points[order[(j + 1) % n]];
+                double delta = a.distanceTo(c) + b.distanceTo(d)
+                             - a.distanceTo(b) - c.distanceTo(d);
+                if (delta < -1e-12) {
+                    std::reverse(order.begin() + i + 1, order.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+    }
+}
+
+// State shared by the recursive branch-and-bound search.
+struct BranchAndBound {
+    unsigned int n;
+    const DistanceMatrix *dist;
+    vector<double> penalty;         // Held-Karp node penalties
+    vector<int> path;               // current partial tour
+    vector<bool> visited;
+    vector<int> bestPath;
+    double bestLength;
+    SearchStats stats;
+
+    // Scratch space for the lower bound.
+    vector<int> unvisited;
+    vector<double> key;
+    vector<int> parent;
+
+    double d(int i, int j) const {
+        return (*dist)(i, j);
+    }
+
+    // Distance with the penalties of both endpoints added.
+    double dp(int i, int j) const {
+        return (*dist)(i, j) + penalty[i] + penalty[j];
+    }
+
+    /*
+     * Computes the minimum 1-tree under the penalized distances: an MST of
+     * cities 1 .. n - 1 plus the two cheapest edges at city 0. Every tour is
+     * a 1-tree, so its penalized cost minus twice the penalty sum is a lower
+     * bound on the optimal tour. Writes the degree of every city to
+     * >degree< and returns the (unpenalized) bound.
+     */
+    double oneTree(vector<int> &degree) {
+        degree.assign(n, 0);
+        key.assign(n, INFINITY);
+        parent.assign(n, -1);
+        vector<bool> inTree(n, false);
+        inTree[0] = true;
+        key[1] = 0;
+
+        double cost = 0;
+        for (unsigned int added = 1; added < n; added++) {
+            int u = -1;
+            for (unsigned int c = 1; c < n; c++) {
+                if (!inTree[c] && (u < 0 || key[c] < key[u]))
+                    u = c;
+            }
+            inTree[u] = true;
+            cost += key[u];
+            if (parent[u] >= 0) {
+                degree[u]++;
+                degree[parent[u]]++;
+            }
+            for (unsigned int c = 1; c < n; c++) {
+                if (!inTree[c] && dp(u, c) < key[c]) {
+                    key[c] = dp(u, c);
+                    parent[c] = u;
+                }
+            }
+        }
+
+        // Two cheapest edges at city 0.
+        int first = -1;
+        int second = -1;
+        for (unsigned int c = 1; c < n; c++) {
+            if (first < 0 || dp(0, c) < dp(0, first)) {
+                second = first;
+                first = c;
+            }
+            else if (second < 0 || dp(0, c) < dp(0, second)) {
+                second = c;
+            }
+        }
+        cost += dp(0, first) + dp(0, second);
+        degree[0] = 2;
+        degree[first]++;
+        degree[second]++;
 
-    vector<int> shortestPath = findShortestPath(points);
+        double penaltySum = 0;
+        for (double p : penalty)
+            penaltySum += p;
+        return cost - 2 * penaltySum;
+    }
+
+    /*
+     * Chooses node penalties by subgradient ascent on the 1-tree bound, so
+     * that the penalized distances make the MST bound in lowerBound() much
+     * tighter. Any penalties keep the bound valid; these just make it good.
+     */
+    void computePenalties() {
+        penalty.assign(n, 0);
+        vector<double> bestPenalty = penalty;
+        vector<int> degree;
+        double bestBound = -INFINITY;
+        double step = 2;
+        unsigned int sinceImproved = 0;
+
+        for (unsigned int iter = 0; iter < 50 * n && step > 1e-6; iter++) {
+            double bound = oneTree(degree);
+            if (bound > bestBound + 1e-9) {
+                bestBound = bound;
+                bestPenalty = penalty;
+                sinceImproved = 0;
+            }
+            else if (++sinceImproved >= n) {
+                step /= 2;
+                sinceImproved = 0;
+            }
+
+            double norm = 0;
+            for (unsigned int c = 0; c < n; c++)
+                norm += (degree[c] - 2) * (degree[c] - 2);
+            if (norm == 0)
+                break;      // the 1-tree is a tour, so it is optimal
+
+            double t = step * (bestLength - bound) / norm;
+            for (unsigned int c = 0; c < n; c++)
+                penalty[c] += t * (degree[c] - 2);
+        }
+        penalty = bestPenalty;
+    }
+
+    /*
+     * Lower bound on the length of any path that leaves >current<, visits
+     * every unvisited city and returns to city 0: the path minus its two end
+     * edges is a spanning tree of the unvisited cities, so it is at least
+     * their MST plus the cheapest edge out of >current< and into city 0.
+     * This is evaluated under the penalized distances, under which the path
+     * costs its true length plus the penalties of >current< and city 0 plus
+     * twice the penalties of the unvisited cities.
+     */
+    double lowerBound(int current) {
+        unvisited.clear();
+        double penaltySum = penalty[current] + penalty[0];
+        for (unsigned int c = 0; c < n; c++) {
+            if (!visited[c]) {
+                unvisited.push_back(c);
+                penaltySum += 2 * penalty[c];
+            }
+        }
+        unsigned int m = unvisited.size();
+        if (m == 0)
+            return d(current, 0);
+
+        double fromCurrent = INFINITY;
+        double toStart = INFINITY;
+        for (int c : unvisited) {
+            fromCurrent = std::min(fromCurrent, dp(current, c));
+            toStart = std::min(toStart, dp(c, 0));
+        }
+
+        // Prim's algorithm over the unvisited cities.
+        key.assign(m, INFINITY);
+        key[0] = 0;
+        double mst = 0;
+        for (unsigned int added = 0; added < m; added++) {
+            unsigned int u = added;
+            for (unsigned int i = added + 1; i < m; i++) {
+                if (key[i] < key[u])
+                    u = i;
+            }
+            // Move the chosen city to the front of the remaining range.
+            std::swap(key[u], key[added]);
+            std::swap(unvisited[u], unvisited[added]);
+            mst += key[added];
+
+            int city = unvisited[added];
+            for (unsigned int i = added + 1; i < m; i++)
+                key[i] = std::min(key[i], dp(city, unvisited[i]));
+        }
+
+        return fromCurrent + mst + toStart - penaltySum;
+    }
+
+    void search(double length) {
+        int current = path.back();
+        if (path.size() == n) {
+            double total = length + d(current, 0);
+            if (total < bestLength) {
+                bestLength = total;
+                bestPath = path;
+            }
+            return;
+        }
+
+        if (length + lowerBound(current) >= bestLength) {
+            stats.nodesPruned++;
+            return;
+        }
+        stats.nodesExpanded++;
+
+        // Try the closest cities first so good tours are found early.
+        vector<int> children;
+        for (unsigned int c = 0; c < n; c++) {
+            if (!visited[c])
+                children.push_back(c);
+        }
+        std::sort(children.begin(), children.end(), [&](int a, int b) {
+            return dp(current, a) < dp(current, b);
+        });
+
+        for (int c : children) {
+            visited[c] = true;
+            path.push_back(c);
+            search(length + d(current, c));
+            path.pop_back();
+            visited[c] = false;
+        }
+    }
+};
+
+/*
+ * Solves the TSP exactly by depth-first branch and bound.
+ *
+ * Tours are built city by city starting at city 0. A partial tour is
+ * abandoned as soon as its length plus a lower bound on the rest of the
+ * tour (see BranchAndBound::lowerBound) is no better than the best complete
+ * tour found so far. The bound uses Held-Karp 1-tree penalties computed once
+ * at the root. The search starts from a nearest-neighbour tour that has been
+ * polished with 2-opt, so most of the tree is pruned from the start. Node
+ * counts are written to >stats< if it is not null.
+ */
+vector<int> findShortestPathBranchAndBound(const vector<Point> &points,
+                                           SearchStats *stats) {
+    unsigned int n = points.size();
+    vector<int> seed = nearestNeighbourTour(points);
+    if (n <= 3)
+        return seed;
+    improveTwoOpt(points, seed);
+
+    DistanceMatrix dist(points);
+    BranchAndBound bb;
+    bb.n = n;
+    bb.dist = &dist;
+    bb.visited.assign(n, false);
+    bb.bestPath = seed;
+    bb.bestLength = circuitLength(dist, seed);
+    bb.computePenalties();
+
+    bb.visited[0] = true;
+    bb.path.push_back(0);
+    bb.search(0);
+
+    if (stats)
+        *stats = bb.stats;
+    return bb.bestPath;
+}
+
+/*
+ * Runs the named solver on >points<. In batch mode many instances already
+ * run at once, so the parallel solver is limited to >numThreads< threads.
+ */
+vector<int> solve(const string &solver, const vector<Point> &points,
+                  unsigned int numThreads, SearchStats *stats) {
+    if (solver == "held-karp")
+        return findShortestPathHeldKarp(points);
+    else if (solver == "parallel")
+        return findShortestPathParallel(points, numThreads);
+    else if (solver == "branch-and-bound")
+        return findShortestPathBranchAndBound(points, stats);
+    else
+        return findShortestPath(points);
+}
+
+void usage() {
+    cout << "usage: ./tsp [brute|parallel|held-karp|branch-and-bound] "
+         << "[--threads N] [--input file] [--batch file-or-dir ...]" << endl;
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    string solver = "brute";
+    unsigned int numThreads = 0;
+    string inputFile;
+    vector<string> batchPaths;
+    bool batch = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (batch && arg.compare(0, 2, "--") != 0)
+            batchPaths.push_back(arg);
+        else if (arg == "--batch")
+            batch = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (arg == "--input" && i + 1 < argc)
+            inputFile = argv[++i];
+        else if (i == 1 && arg[0] != '-')
+            solver = arg;
+        else
+            usage();
+    }
+
+    if (solver != "brute" && solver != "parallel" && solver != "held-karp" &&
+        solver != "branch-and-bound") {
+        cout << "input error: unknown solver " << solver << endl;
+        exit(1);
+    }
+
+    if (batch) {
+        if (batchPaths.empty())
+            usage();
+
+        // Instances are spread over the pool, so each one runs on a single
+        // thread. Instances too big for the solver are reported as errors.
+        InstanceSolver solveOne = [&](const vector<Point> &points,
+                                      vector<int> &order) {
+            if (solver == "held-karp" &&
+                points.size() > HELD_KARP_MAX_POINTS)
+                return -1.0;
+            if ((solver == "brute" || solver == "parallel") &&
+                points.size() > BRUTE_FORCE_BATCH_MAX_POINTS)
+                return -1.0;
+            order = solve(solver, points, 1, nullptr);
+            return circuitLength(points, order);
+        };
+
+        vector<string> files = listInstanceFiles(batchPaths);
+        vector<BatchResult> results = runBatch(files, solveOne, numThreads);
+        for (const BatchResult &result : results)
+            printBatchResult(cout, result);
+        cout.flush();
+        return 0;
+    }
+
+    vector<Point> points;
+    if (!inputFile.empty()) {
+        // Text or binary point file, no prompts.
+        if (!loadPoints(inputFile, points)) {
+            cout << "input error: cannot read points from " << inputFile
+                 << endl;
+            exit(1);
+        }
+    }
+    else {
+        unsigned int num_points;
+        cout << "How many points? ";
+        cin >> num_points;
+
+        points.resize(num_points);
+        double x, y, z;
+        for (unsigned int i = 0; i < num_points; i++) {
+            cout << "Point " << i << ": ";
+            cin >> x >> y >> z;
+            Point p(x, y, z);
+            points[i] = p;
+        }
+    }
+
+    if (solver == "held-karp" && points.size() > HELD_KARP_MAX_POINTS) {
+        cout << "input error: held-karp supports at most "
+             << HELD_KARP_MAX_POINTS << " points" << endl;
+        exit(1);
+    }
+
+    SearchStats stats;
+    vector<int> shortestPath = solve(solver, points, numThreads, &stats);
     double shortestLength = circuitLength(points, shortestPath);
 
+    if (solver == "branch-and-bound") {
+        cout << "Nodes expanded: " << stats.nodesExpanded << endl;
+        cout << "Nodes pruned: " << stats.nodesPruned << endl;
+    }
+
     cout << "Best order: [";
-    for (unsigned int i; i < shortestPath.size(); i++) {
+    for (unsigned int i = 0; i < shortestPath.size(); i++) {
         cout << shortestPath[i];
         if (i < shortestPath.size() - 1)
             cout << " ";
@@ -0,0 +1,122 @@
+#ifndef ARRAY_TOUR_HH
+#define ARRAY_TOUR_HH
+
+#include <cassert>
+#include <vector>
+using namespace std;
+
+
+// A tour stored as an array of cities plus the position of every city, so
+// next/prev are O(1). The tour works on the caller's order vector in
+// place, and keeps the positions in its own vector or in one the caller
+// lends it for reuse. Changes are made by 2-opt moves, which reverse the
+// shorter side of the tour, and by swapping two cities, which is O(1).
+class ArrayTour {
+
+private:
+    vector<int> &order;
+    vector<int> ownPos;
+    vector<int> &pos;
+    int n;
+
+    // Reverses the cities at positions i, i + 1, ..., j (cyclically).
+    void reversePath(int i, int j) {
+        int len = (j - i + n) % n + 1;
+        for (int s = 0; s < len / 2; s++) {
+            int a = order[i];
+            int b = order[j];
+            order[i] = b;
+            pos[b] = i;
+            order[j] = a;
+            pos[a] = j;
+            i = (i + 1) % n;
+            j = (j - 1 + n) % n;
+        }
+    }
+
+public:
+    ArrayTour(vector<int> &order) : ArrayTour(order, ownPos) {}
+
+    ArrayTour(vector<int> &order, vector<int> &posBuffer)
+        : order(order), pos(posBuffer), n(order.size()) {
+        pos.resize(n);
+        for (int i = 0; i < n; i++)
+            pos[order[i]] = i;
+    }
+
+    // The positions may live in this object, so copies would share them.
+    ArrayTour(const ArrayTour &) = delete;
+    ArrayTour &operator=(const ArrayTour &) = delete;
+
+    int next(int c) const {
+        int p = pos[c] + 1;
+        return order[p == n ? 0 : p];
+    }
+
+    int prev(int c) const {
+        int p = pos[c];
+        return order[p == 0 ? n - 1 : p - 1];
+    }
+
+    // True if b lies on the path from a forwards to c (inclusive).
+    bool between(int a, int b, int c) const {
+        int pa = pos[a], pb = pos[b], pc = pos[c];
+        if (pa <= pc)
+            return pa <= pb && pb <= pc;
+        return pb >= pa || pb <= pc;
+    }
+
+    /*
+     * Replaces edges (a, b) and (c, d), where b = next(a) and d = next(c),
+     * with (a, c) and (b, d). Either the path b..c or the path d..a has to
+     * be reversed; the shorter one is.
+     */
+    void twoOptMove(int a, int b, int c, int d) {
+        assert(next(a) == b && next(c) == d);
+        int inside = (pos[c] - pos[b] + n) % n + 1;
+        if (2 * inside <= n)
+            reversePath(pos[b], pos[c]);
+        else
+            reversePath(pos[d], pos[a]);
+    }
+
+    /*
+     * Replaces edges {a, b} and {c, d} with {a, c} and {b, d}, where b and d
+     * follow a and c in the same direction, whichever that is.
+     */
+    void exchange(int a, int b, int c, int d) {
+        if (next(a) == b)
+            twoOptMove(a, b, c, d);
+        else
+            twoOptMove(b, a, d, c);
+    }
+
+    /*
+     * Moves the segment s1..s2 (forwards) between x and y = next(x), either
+     * as x s1..s2 y or, if >reversed<, as x s2..s1 y. Done as two or three
+     * 2-opt exchanges. Neither x nor y may be in the segment or be the city
+     * just before it.
+     */
+    void moveSegment(int s1, int s2, int x, int y, bool reversed) {
+        int p = prev(s1);
+        int q = next(s2);
+        exchange(p, s1, x, y);      // p x ... q s2 .. s1 y
+        if (x != q)
+            exchange(p, x, q, s2);  // p q ... x s2 .. s1 y
+        if (!reversed)
+            exchange(x, s2, s1, y);
+    }
+
+    // Swaps the positions of cities a and b.
+    void swapCities(int a, int b) {
+        int pa = pos[a];
+        int pb = pos[b];
+        order[pa] = b;
+        pos[b] = pa;
+        order[pb] = a;
+        pos[a] = pb;
+    }
+};
+
+
+#endif // ARRAY_TOUR_HH
@@ -0,0 +1,172 @@
+#ifndef DISTANCE_MATRIX_HH
+#define DISTANCE_MATRIX_HH
+
+#include "Point.hh"
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+using namespace std;
+
+
+// How a distance matrix stores its distances.
+enum class MatrixLayout {
+    FULL,           // n x n table, every row starting on a cache line
+    TRIANGULAR,     // lower triangle only, about half the memory of FULL
+    ON_THE_FLY      // nothing stored, distances computed on every lookup
+};
+
+// Above this many points a distance matrix computes distances on the fly
+// unless told otherwise. A FULL double table for this size is 512 MB.
+const unsigned int DEFAULT_MAX_CACHED_POINTS = 8192;
+
+
+// Pairwise distances between a fixed set of points, computed once with
+// Point::distanceTo (or another symmetric distance function) and then
+// looked up. T is the stored type, so a float matrix halves the memory at
+// the cost of precision.
+//
+// The table is symmetric. The FULL layout pads every row to a multiple of
+// a 64-byte cache line and aligns the table itself, so a row never shares
+// a line with its neighbour. The TRIANGULAR layout stores only entries with
+// i >= j. Instances with more than >maxCachedPoints< points are never
+// tabulated; those lookups compute the distance from a copy of the points
+// in T precision, kept 2-D when every z is 0 so each lookup reads two
+// coordinates rather than three.
+template <typename T>
+class BasicDistanceMatrix {
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    MatrixLayout layout;
+    size_t numPoints;
+    size_t stride;              // elements per row in the FULL layout
+    vector<T> storage;
+    T *table;                   // aligned start of the table in storage
+    // Only kept for the ON_THE_FLY layout, one or the other.
+    vector<BasicPoint<T, 2>> planarPoints;
+    vector<BasicPoint<T, 3>> spatialPoints;
+
+    // Index of (i, j) in the TRIANGULAR layout, assuming i >= j.
+    static size_t triangle(size_t i, size_t j) {
+        return i * (i + 1) / 2 + j;
+    }
+
+    // Allocates >count< elements with the first one cache-line aligned.
+    void allocate(size_t count) {
+        size_t slack = CACHE_LINE / sizeof(T);
+        storage.assign(count + slack, 0);
+        uintptr_t addr = reinterpret_cast<uintptr_t>(storage.data());
+        size_t offset = (CACHE_LINE - addr % CACHE_LINE) % CACHE_LINE;
+        table = storage.data() + offset / sizeof(T);
+    }
+
+    // Fills a FULL table with >distance(i, j)< for every i > j.
+    template <typename Distance>
+    void tabulate(Distance distance) {
+        size_t perLine = CACHE_LINE / sizeof(T);
+        stride = (numPoints + perLine - 1) / perLine * perLine;
+        allocate(numPoints * stride);
+        for (size_t i = 0; i < numPoints; i++) {
+            table[i * stride + i] = 0;
+            for (size_t j = 0; j < i; j++) {
+                T d = (T) distance(i, j);
+                table[i * stride + j] = d;
+                table[j * stride + i] = d;
+            }
+        }
+    }
+
+public:
+    // Constructors
+    BasicDistanceMatrix(const vector<Point> &pts,
+                        MatrixLayout layout = MatrixLayout::FULL,
+                        unsigned int maxCachedPoints =
+                            DEFAULT_MAX_CACHED_POINTS)
+        : layout(layout), numPoints(pts.size()), stride(0), table(nullptr) {
+        if (numPoints > maxCachedPoints)
+            this->layout = MatrixLayout::ON_THE_FLY;
+
+        switch (this->layout) {
+        case MatrixLayout::FULL:
+            tabulate([&pts](size_t i, size_t j) {
+                return pts[i].distanceTo(pts[j]);
+            });
+            break;
+        case MatrixLayout::TRIANGULAR:
+            allocate(triangle(numPoints, 0));
+            for (size_t i = 0; i < numPoints; i++) {
+                for (size_t j = 0; j <= i; j++)
+                    table[triangle(i, j)] = (T) pts[i].distanceTo(pts[j]);
+            }
+            break;
+        case MatrixLayout::ON_THE_FLY: {
+            bool planar = true;
+            for (const Point &p : pts)
+                planar = planar && p.getZ() == 0;
+            for (const Point &p : pts) {
+                if (planar)
+                    planarPoints.emplace_back(p);
+                else
+                    spatialPoints.emplace_back(p);
+            }
+            break;
+        }
+        }
+    }
+
+    // A FULL matrix of >n< cities, for a metric that is not distanceTo
+    // between points (such as TSPLIB's GEO or EXPLICIT distances):
+    // >distance(i, j)< is called once for every pair i > j.
+    template <typename Distance>
+    BasicDistanceMatrix(size_t n, Distance distance)
+        : layout(MatrixLayout::FULL), numPoints(n), stride(0),
+          table(nullptr) {
+        tabulate(distance);
+    }
+
+    // The aligned table pointer would dangle in a copy, so only moves are
+    // allowed (a moved vector keeps its buffer).
+    BasicDistanceMatrix(const BasicDistanceMatrix &) = delete;
+    BasicDistanceMatrix &operator=(const BasicDistanceMatrix &) = delete;
+    BasicDistanceMatrix(BasicDistanceMatrix &&) = default;
+    BasicDistanceMatrix &operator=(BasicDistanceMatrix &&) = default;
+
+    // Accessor methods
+    size_t size() const {
+        return numPoints;
+    }
+
+    MatrixLayout getLayout() const {
+        return layout;
+    }
+
+    // Returns the distance between points i and j.
+    T operator()(size_t i, size_t j) const {
+        assert(i < numPoints && j < numPoints);
+        switch (layout) {
+        case MatrixLayout::FULL:
+            return table[i * stride + j];
+        case MatrixLayout::TRIANGULAR:
+            return i >= j ? table[triangle(i, j)] : table[triangle(j, i)];
+        default:
+            if (!planarPoints.empty())
+                return planarPoints[i].distanceTo(planarPoints[j]);
+            return spatialPoints[i].distanceTo(spatialPoints[j]);
+        }
+    }
+
+    // Returns row i of a FULL matrix, or null for the other layouts.
+    const T *row(size_t i) const {
+        if (layout != MatrixLayout::FULL)
+            return nullptr;
+        return table + i * stride;
+    }
+};
+
+typedef BasicDistanceMatrix<double> DistanceMatrix;
+typedef BasicDistanceMatrix<float> FloatDistanceMatrix;
+
+
+#endif // DISTANCE_MATRIX_HH
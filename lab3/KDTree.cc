@@ -0,0 +1,235 @@
+#include "KDTree.hh"
+#include "ThreadPool.hh"
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+
+// Builds the tree over >points<. Takes O(n log n) time.
+KDTree::KDTree(const vector<Point> &points) {
+    this->numPoints = points.size();
+    this->index.resize(this->numPoints);
+    this->splitDim.assign(this->numPoints, 0);
+    for (int i = 0; i < this->numPoints; i++)
+        this->index[i] = i;
+
+    // Build over the original coordinates, indexed by point.
+    for (int d = 0; d < 3; d++)
+        this->coords[d].resize(this->numPoints);
+    for (int i = 0; i < this->numPoints; i++) {
+        this->coords[0][i] = points[i].getX();
+        this->coords[1][i] = points[i].getY();
+        this->coords[2][i] = points[i].getZ();
+    }
+    this->build(0, this->numPoints);
+
+    // Then store the coordinates in tree order.
+    for (int d = 0; d < 3; d++) {
+        vector<double> ordered(this->numPoints);
+        for (int i = 0; i < this->numPoints; i++)
+            ordered[i] = this->coords[d][this->index[i]];
+        this->coords[d].swap(ordered);
+    }
+}
+
+
+// Arranges index[lo, hi) into a subtree: the median along the dimension of
+// largest spread goes in the middle, smaller points before it and larger
+// points after it. Called before coords[] is put in tree order.
+void KDTree::build(int lo, int hi) {
+    if (hi - lo <= LEAF_SIZE)
+        return;
+
+    int dim = 0;
+    double bestSpread = -1;
+    for (int d = 0; d < 3; d++) {
+        const vector<double> &c = this->coords[d];
+        double lowest = c[this->index[lo]];
+        double highest = lowest;
+        for (int i = lo + 1; i < hi; i++) {
+            lowest = std::min(lowest, c[this->index[i]]);
+            highest = std::max(highest, c[this->index[i]]);
+        }
+        if (highest - lowest > bestSpread) {
+            bestSpread = highest - lowest;
+            dim = d;
+        }
+    }
+
+    int mid = (lo + hi) / 2;
+    const vector<double> &c = this->coords[dim];
+    std::nth_element(this->index.begin() + lo, this->index.begin() + mid,
+                     this->index.begin() + hi,
+                     [&c](int a, int b) { return c[a] < c[b]; });
+    this->splitDim[mid] = dim;
+
+    this->build(lo, mid);
+    this->build(mid + 1, hi);
+}
+
+
+// Squared distance from the point in tree slot >slot< to >q<.
+double KDTree::distance2(int slot, const double q[3]) const {
+    double dx = this->coords[0][slot] - q[0];
+    double dy = this->coords[1][slot] - q[1];
+    double dz = this->coords[2][slot] - q[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+
+// Adds a candidate to a k-nearest heap. Ties are broken by point index, so
+// results do not depend on the shape of the tree.
+void KDTree::offer(Heap &heap, int k, double d2, int point) const {
+    pair<double, int> candidate(d2, point);
+    if ((int) heap.size() < k) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+    }
+    else if (candidate < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+
+// Recursive k-nearest search of the subtree [lo, hi).
+void KDTree::nearest(int lo, int hi, const double q[3], int k, int exclude,
+                     Heap &heap) const {
+    if (hi - lo <= LEAF_SIZE) {
+        for (int i = lo; i < hi; i++) {
+            if (this->index[i] != exclude)
+                this->offer(heap, k, this->distance2(i, q), this->index[i]);
+        }
+        return;
+    }
+
+    int mid = (lo + hi) / 2;
+    int dim = this->splitDim[mid];
+    double diff = q[dim] - this->coords[dim][mid];
+    if (this->index[mid] != exclude)
+        this->offer(heap, k, this->distance2(mid, q), this->index[mid]);
+
+    // Search the side q is on first, then the other side only if the
+    // splitting plane is closer than the current k-th neighbour.
+    if (diff < 0)
+        this->nearest(lo, mid, q, k, exclude, heap);
+    else
+        this->nearest(mid + 1, hi, q, k, exclude, heap);
+
+    if ((int) heap.size() < k || diff * diff <= heap.front().first) {
+        if (diff < 0)
+            this->nearest(mid + 1, hi, q, k, exclude, heap);
+        else
+            this->nearest(lo, mid, q, k, exclude, heap);
+    }
+}
+
+
+// Recursive radius search of the subtree [lo, hi).
+void KDTree::withinRadius(int lo, int hi, const double q[3], double r2,
+                          vector<int> &result) const {
+    if (hi - lo <= LEAF_SIZE) {
+        for (int i = lo; i < hi; i++) {
+            if (this->distance2(i, q) <= r2)
+                result.push_back(this->index[i]);
+        }
+        return;
+    }
+
+    int mid = (lo + hi) / 2;
+    int dim = this->splitDim[mid];
+    double diff = q[dim] - this->coords[dim][mid];
+    if (this->distance2(mid, q) <= r2)
+        result.push_back(this->index[mid]);
+
+    if (diff <= 0 || diff * diff <= r2)
+        this->withinRadius(lo, mid, q, r2, result);
+    if (diff >= 0 || diff * diff <= r2)
+        this->withinRadius(mid + 1, hi, q, r2, result);
+}
+
+
+// Gets the number of points in the tree.
+int KDTree::size() const {
+    return this->numPoints;
+}
+
+
+// Finds the >k< points nearest to >q<, nearest first, leaving out point
+// >exclude< (pass -1 to keep every point).
+void KDTree::nearest(const Point &q, int k, vector<int> &result,
+                     int exclude) const {
+    result.clear();
+    if (k <= 0 || this->numPoints == 0)
+        return;
+
+    double qc[3] = { q.getX(), q.getY(), q.getZ() };
+    Heap heap;
+    heap.reserve(k + 1);
+    this->nearest(0, this->numPoints, qc, k, exclude, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+    for (const pair<double, int> &h : heap)
+        result.push_back(h.second);
+}
+
+
+// Finds every point within >radius< of >q<, in no particular order.
+void KDTree::withinRadius(const Point &q, double radius,
+                          vector<int> &result) const {
+    result.clear();
+    if (this->numPoints == 0)
+        return;
+
+    double qc[3] = { q.getX(), q.getY(), q.getZ() };
+    this->withinRadius(0, this->numPoints, qc, radius * radius, result);
+}
+
+
+/*
+ * Finds the >k< nearest other points of every point, on >numThreads<
+ * threads (0 means one per hardware thread). Returns a flat array whose
+ * row i holds the neighbours of point i, nearest first; k is clamped to
+ * size() - 1.
+ */
+vector<int> KDTree::allNearest(int k, unsigned int numThreads) const {
+    k = std::max(0, std::min(k, this->numPoints - 1));
+    vector<int> result((size_t) this->numPoints * k);
+    if (k == 0)
+        return result;
+
+    // Walk the points in tree order so consecutive queries touch the same
+    // part of the tree.
+    auto queryRange = [this, k, &result](int begin, int end) {
+        Heap heap;
+        heap.reserve(k + 1);
+        for (int slot = begin; slot < end; slot++) {
+            int point = this->index[slot];
+            double q[3] = { this->coords[0][slot], this->coords[1][slot],
+                            this->coords[2][slot] };
+            heap.clear();
+            this->nearest(0, this->numPoints, q, k, point, heap);
+            std::sort_heap(heap.begin(), heap.end());
+            for (int r = 0; r < k; r++)
+                result[(size_t) point * k + r] = heap[r].second;
+        }
+    };
+
+    // A single thread needs no pool.
+    if (numThreads == 1) {
+        queryRange(0, this->numPoints);
+        return result;
+    }
+
+    const int CHUNK = 1024;
+    ThreadPool pool(numThreads);
+    for (int begin = 0; begin < this->numPoints; begin += CHUNK) {
+        int end = std::min(this->numPoints, begin + CHUNK);
+        pool.submit([&queryRange, begin, end]() {
+            queryRange(begin, end);
+        });
+    }
+    pool.wait();
+    return result;
+}
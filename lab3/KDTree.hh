@@ -0,0 +1,57 @@
+#ifndef KDTREE_HH
+#define KDTREE_HH
+
+#include "Point.hh"
+#include <utility>
+#include <vector>
+using namespace std;
+
+
+// A static k-d tree over a set of 3-D points, for nearest-neighbour and
+// radius queries.
+//
+// The tree is implicit: building it only permutes an array of point
+// indices, so there are no node objects and no per-node allocations. The
+// node for an index range [lo, hi) is its middle element, split along the
+// dimension stored for that element; its children are the two halves.
+// Ranges of at most LEAF_SIZE points are leaves and are scanned linearly.
+// Coordinates are copied into one array per dimension in tree order, so a
+// leaf scan reads contiguous memory.
+class KDTree {
+
+private:
+    static const int LEAF_SIZE = 8;
+
+    int numPoints;
+    vector<int> index;              // point indices in tree order
+    vector<unsigned char> splitDim; // split dimension of each node
+    vector<double> coords[3];       // coordinates in tree order
+
+    // Max-heap of (squared distance, point) pairs.
+    typedef vector<pair<double, int>> Heap;
+
+    void build(int lo, int hi);
+    double distance2(int slot, const double q[3]) const;
+    void offer(Heap &heap, int k, double d2, int point) const;
+    void nearest(int lo, int hi, const double q[3], int k, int exclude,
+                 Heap &heap) const;
+    void withinRadius(int lo, int hi, const double q[3], double r2,
+                      vector<int> &result) const;
+
+public:
+    // Constructors
+    KDTree(const vector<Point> &points);
+
+    // Accessor methods
+    int size() const;
+
+    // Queries
+    void nearest(const Point &q, int k, vector<int> &result,
+                 int exclude = -1) const;
+    void withinRadius(const Point &q, double radius,
+                      vector<int> &result) const;
+    vector<int> allNearest(int k, unsigned int numThreads = 0) const;
+};
+
+
+#endif // KDTREE_HH
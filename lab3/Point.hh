@@ -1,30 +1,103 @@
-// A 3-dimensional point class!
-// Coordinates are double-precision floating point.
-class Point {
+#ifndef POINT_HH
+#define POINT_HH
+
+#include <cmath>
+
+// A point class, specialized at compile time for its scalar type T (float
+// or double) and its number of dimensions Dim (2 or 3)!
+//
+// Point is the original 3-dimensional point with double-precision
+// coordinates. Two-dimensional points drop the z coordinate altogether
+// (getZ() is always 0), and float points halve the size again, which
+// matters when a distance kernel streams over millions of them.
+template <typename T, int Dim>
+class BasicPoint {
+
+  static_assert(Dim == 2 || Dim == 3, "points are 2-D or 3-D");
 
 private:
-  double x_coord;
-  double y_coord;
-  double z_coord;
+  T coords[Dim];
 
 public:
+  typedef T Scalar;
+  static const int DIMENSION = Dim;
+
   // Constructors
-  Point();                                // default constructor
-  Point(double x, double y, double z);    // three-argument constructor
+  BasicPoint() {                          // default constructor
+    for (int d = 0; d < Dim; d++)
+      coords[d] = 0;
+  }
 
-  // Destructor
-  ~Point();
+  BasicPoint(T x, T y, T z = 0) {         // z is dropped by 2-D points
+    coords[0] = x;
+    coords[1] = y;
+    if (Dim == 3)
+      coords[Dim - 1] = z;
+  }
+
+  // Converts from a point of another scalar type or dimension.
+  template <typename U, int D>
+  explicit BasicPoint(const BasicPoint<U, D> &p)
+    : BasicPoint((T) p.getX(), (T) p.getY(), (T) p.getZ()) {}
 
   // Mutator methods
-  void setX(double val);
-  void setY(double val);
-  void setZ(double val);
+  void setX(T val) { coords[0] = val; }
+  void setY(T val) { coords[1] = val; }
+  void setZ(T val) {
+    if (Dim == 3)
+      coords[Dim - 1] = val;
+  }
 
   // Accessor methods
-  double getX() const;
-  double getY() const ;
-  double getZ() const;
+  T getX() const { return coords[0]; }
+  T getY() const { return coords[1]; }
+  T getZ() const { return Dim == 3 ? coords[Dim - 1] : 0; }
 
   // Other methods
-  double distanceTo(const Point &p) const;
+
+  // Squared distance, for comparisons that need no square root.
+  T distance2To(const BasicPoint &p) const;
+
+  T distanceTo(const BasicPoint &p) const {
+    return std::sqrt(this->distance2To(p));
+  }
 };
+
+// The distance kernels are written out per dimension, so they compile to
+// straight-line code with no loop or unused coordinate.
+template <>
+inline float BasicPoint<float, 2>::distance2To(const BasicPoint &p) const {
+  float dx = p.coords[0] - coords[0];
+  float dy = p.coords[1] - coords[1];
+  return dx * dx + dy * dy;
+}
+
+template <>
+inline double BasicPoint<double, 2>::distance2To(const BasicPoint &p) const {
+  double dx = p.coords[0] - coords[0];
+  double dy = p.coords[1] - coords[1];
+  return dx * dx + dy * dy;
+}
+
+template <>
+inline float BasicPoint<float, 3>::distance2To(const BasicPoint &p) const {
+  float dx = p.coords[0] - coords[0];
+  float dy = p.coords[1] - coords[1];
+  float dz = p.coords[2] - coords[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+template <>
+inline double BasicPoint<double, 3>::distance2To(const BasicPoint &p) const {
+  double dx = p.coords[0] - coords[0];
+  double dy = p.coords[1] - coords[1];
+  double dz = p.coords[2] - coords[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+typedef BasicPoint<double, 3> Point;
+typedef BasicPoint<double, 2> Point2d;
+typedef BasicPoint<float, 3> Point3f;
+typedef BasicPoint<float, 2> Point2f;
+
+#endif // POINT_HH
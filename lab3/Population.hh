@@ -0,0 +1,289 @@
+#ifndef POPULATION_HH
+#define POPULATION_HH
+
+#include "DistanceMatrix.hh"
+#include "Random.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+
+// A lightweight view of one genome stored in a Population: its row of the
+// order matrix, its cached circuit length, and whether that length is up
+// to date. Views are plain pointers and are only valid until the
+// population's buffers are swapped.
+template <typename Index>
+struct GenomeView {
+    Index *order;
+    double *length;
+    unsigned char *valid;   // 0 when the order changed since the length
+};
+
+
+// The whole GA population stored as one populationSize x numCities matrix
+// of city indices, plus a cached length per genome. Index is uint16_t when
+// the cities fit, halving the memory traffic, and uint32_t otherwise.
+//
+// There are two such matrices. One holds the current generation; the next
+// generation is bred into the other, and swapBuffers() flips them. All the
+// memory is allocated up front, so a run allocates nothing per genome or
+// per generation.
+//
+// Each genome also carries a valid flag. Only genomes whose flag is clear
+// need a full evaluation; elites keep theirs when carried over, and
+// mutateGenome keeps the length up to date itself.
+template <typename Index>
+class Population {
+
+private:
+    int numGenomes;
+    int numCities;
+    vector<Index> orders[2];
+    vector<double> lengths[2];
+    vector<unsigned char> valid[2];
+    int current;                // which buffer holds this generation
+
+    size_t offset(int i) const {
+        return (size_t) i * this->numCities;
+    }
+
+public:
+    // Constructors
+    Population(int numGenomes, int numCities)
+        : numGenomes(numGenomes), numCities(numCities), current(0) {
+        for (int b = 0; b < 2; b++) {
+            this->orders[b].assign((size_t) numGenomes * numCities, 0);
+            this->lengths[b].assign(numGenomes, 0);
+            this->valid[b].assign(numGenomes, 0);
+        }
+    }
+
+    // Accessor methods
+    int size() const {
+        return this->numGenomes;
+    }
+
+    int getNumCities() const {
+        return this->numCities;
+    }
+
+    // Genome i of the current generation.
+    GenomeView<Index> genome(int i) {
+        GenomeView<Index> g = { &this->orders[this->current][this->offset(i)],
+                                &this->lengths[this->current][i],
+                                &this->valid[this->current][i] };
+        return g;
+    }
+
+    // Slot i of the generation being bred.
+    GenomeView<Index> nextGenome(int i) {
+        int next = 1 - this->current;
+        GenomeView<Index> g = { &this->orders[next][this->offset(i)],
+                                &this->lengths[next][i],
+                                &this->valid[next][i] };
+        return g;
+    }
+
+    const Index *getOrder(int i) const {
+        return &this->orders[this->current][this->offset(i)];
+    }
+
+    double getLength(int i) const {
+        return this->lengths[this->current][i];
+    }
+
+    bool isValid(int i) const {
+        return this->valid[this->current][i] != 0;
+    }
+
+    // Other methods
+
+    // Copies genome >from< of this generation into slot >to< of the next.
+    void carryOver(int from, int to) {
+        int next = 1 - this->current;
+        memcpy(&this->orders[next][this->offset(to)],
+               &this->orders[this->current][this->offset(from)],
+               this->numCities * sizeof(Index));
+        this->lengths[next][to] = this->lengths[this->current][from];
+        this->valid[next][to] = this->valid[this->current][from];
+    }
+
+    // Size in bytes of the current generation as save() writes it.
+    size_t snapshotBytes() const {
+        return (size_t) this->numGenomes * (sizeof(double) + 1) +
+               this->orders[0].size() * sizeof(Index);
+    }
+
+    // Copies the current generation's lengths, orders and valid flags to
+    // >out<, straight from the flat buffers.
+    void save(char *out) const {
+        const vector<double> &lengths = this->lengths[this->current];
+        const vector<Index> &orders = this->orders[this->current];
+        const vector<unsigned char> &valid = this->valid[this->current];
+        memcpy(out, lengths.data(), lengths.size() * sizeof(double));
+        out += lengths.size() * sizeof(double);
+        memcpy(out, orders.data(), orders.size() * sizeof(Index));
+        out += orders.size() * sizeof(Index);
+        memcpy(out, valid.data(), valid.size());
+    }
+
+    // Replaces the current generation with one written by save().
+    void load(const char *in) {
+        vector<double> &lengths = this->lengths[this->current];
+        vector<Index> &orders = this->orders[this->current];
+        vector<unsigned char> &valid = this->valid[this->current];
+        memcpy(lengths.data(), in, lengths.size() * sizeof(double));
+        in += lengths.size() * sizeof(double);
+        memcpy(orders.data(), in, orders.size() * sizeof(Index));
+        in += orders.size() * sizeof(Index);
+        memcpy(valid.data(), in, valid.size());
+    }
+
+    // Makes the generation that was being bred the current one.
+    void swapBuffers() {
+        this->current = 1 - this->current;
+    }
+};
+
+
+/* ========== Operations on flat genomes ========== */
+
+// Computes the length of the round trip visiting the cities in >order<.
+template <typename Index>
+double orderLength(const Index *order, int n, const DistanceMatrix &dist) {
+    double length = 0;
+    for (int i = 0; i < n; i++) {
+        int next;
+        if (i == n - 1)
+            next = 0;
+        else
+            next = i + 1;
+
+        length += dist(order[i], order[next]);
+    }
+    return length;
+}
+
+// Same as above, but computes the distances from the points themselves,
+// with the distance kernel of their BasicPoint type.
+template <typename Index, typename P>
+double orderLength(const Index *order, int n, const vector<P> &points) {
+    double length = 0;
+    for (int i = 0; i < n; i++) {
+        int next;
+        if (i == n - 1)
+            next = 0;
+        else
+            next = i + 1;
+
+        length += points[order[i]].distanceTo(points[order[next]]);
+    }
+    return length;
+}
+
+// Fills >order< with a random permutation of 0 .. n - 1.
+template <typename Index>
+void randomOrder(Index *order, int n, Random &rng) {
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+
+    // Fisher-Yates, spelled out so a seed gives the same order everywhere.
+    for (int i = n - 1; i > 0; i--)
+        std::swap(order[i], order[rng.below(i + 1)]);
+}
+
+// Returns how much the length of the round trip through >order< changes
+// when the cities at positions a and b are swapped, and swaps them. Only
+// the (at most four) edges touching a and b are looked at; when the two
+// positions are adjacent they share an edge, which is counted once.
+template <typename Index>
+double swapWithDelta(Index *order, int n, int a, int b,
+                     const DistanceMatrix &dist) {
+    // Edges are named by the position they start at.
+    int starts[4] = { (a + n - 1) % n, a, (b + n - 1) % n, b };
+    int numStarts = 0;
+    for (int k = 0; k < 4; k++) {
+        bool seen = false;
+        for (int m = 0; m < numStarts; m++)
+            seen = seen || starts[m] == starts[k];
+        if (!seen)
+            starts[numStarts++] = starts[k];
+    }
+
+    double before = 0;
+    for (int k = 0; k < numStarts; k++)
+        before += dist(order[starts[k]], order[(starts[k] + 1) % n]);
+
+    std::swap(order[a], order[b]);
+
+    double after = 0;
+    for (int k = 0; k < numStarts; k++)
+        after += dist(order[starts[k]], order[(starts[k] + 1) % n]);
+
+    return after - before;
+}
+
+// Swaps two randomly-selected cities, like TSPGenome::mutate. If the
+// genome's length is valid, it is updated in O(1) from the changed edges
+// instead of leaving the genome to be re-evaluated.
+template <typename Index>
+void mutateGenome(GenomeView<Index> g, int n, const DistanceMatrix &dist,
+                  Random &rng) {
+    if (n < 2)
+        return;
+
+    int rand1 = rng.below(n);
+    int rand2 = rng.below(n);
+    while (rand2 == rand1) {
+        rand2 = rng.below(n);
+    }
+
+    if (*g.valid)
+        *g.length += swapWithDelta(g.order, n, rand1, rand2, dist);
+    else
+        std::swap(g.order[rand1], g.order[rand2]);
+}
+
+// Returns how much the length of the round trip through >order< changes
+// when the cities at positions lo .. hi are reversed (a 2-opt move), and
+// reverses them. Only the two edges at the ends of the stretch change.
+// The stretch must not be the whole tour.
+template <typename Index>
+double reverseWithDelta(Index *order, int n, int lo, int hi,
+                        const DistanceMatrix &dist) {
+    assert(0 <= lo && lo < hi && hi < n && hi - lo < n - 1);
+    int before = order[(lo + n - 1) % n];
+    int after = order[(hi + 1) % n];
+    double delta = dist(before, order[hi]) + dist(order[lo], after) -
+                   dist(before, order[lo]) - dist(order[hi], after);
+    std::reverse(order + lo, order + hi + 1);
+    return delta;
+}
+
+// Reverses a randomly-selected stretch of the genome. Like mutateGenome,
+// a valid length is kept valid from the edges that changed.
+template <typename Index>
+void invertGenome(GenomeView<Index> g, int n, const DistanceMatrix &dist,
+                  Random &rng) {
+    if (n < 4)
+        return;
+
+    int lo, hi;
+    do {
+        lo = rng.below(n);
+        hi = rng.below(n);
+        if (lo > hi)
+            std::swap(lo, hi);
+    } while (hi == lo || hi - lo == n - 1);
+
+    if (*g.valid)
+        *g.length += reverseWithDelta(g.order, n, lo, hi, dist);
+    else
+        std::reverse(g.order + lo, g.order + hi + 1);
+}
+
+#endif // POPULATION_HH
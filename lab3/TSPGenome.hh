@@ -0,0 +1,126 @@
+#ifndef TSP_GENOME_HH
+#define TSP_GENOME_HH
+
+#include "DistanceMatrix.hh"
+#include "Population.hh"
+#include "crossover.hh"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+using namespace std;
+
+// Represents on possible solution to a Traveling Salesman Problem. Used 
+// to solve TSP with genetic algorithms.
+//
+// Index is the type of the city indices in the order; TSPGenome stores
+// ints, and narrower types halve (uint16_t) the memory of a tour.
+template <typename Index>
+class BasicTSPGenome {
+
+private:
+    vector<Index> order;
+    double circuitLength;
+    static const int DUMMY_LENGTH = 1e9;
+
+public:
+    // Constructors 
+    BasicTSPGenome() {}
+
+    // Constructor that initializes the order vector to be some random 
+    // order of points, drawn from >rng<, and the circuitLength to be equal
+    // to dummyLength.
+    BasicTSPGenome(int numPoints, Random &rng) {
+        this->order.resize(numPoints);
+        randomOrder(this->order.data(), numPoints, rng);
+        this->circuitLength = DUMMY_LENGTH;
+    }
+
+    // Constructor that initializes the order vector with the passed-in
+    // vector.
+    BasicTSPGenome(const vector<Index> &order) {
+        this->order = order;
+        this->circuitLength = DUMMY_LENGTH;
+    }
+
+    // Destructor 
+    ~BasicTSPGenome() {}
+
+    // Accessor methods 
+
+    // Gets genome's current visit order.
+    const vector<Index> &getOrder() const {
+        return this->order;
+    }
+
+    // Gets genome's current circuit length.
+    double getCircuitLength() const {
+        return this->circuitLength;
+    }
+
+    // Other methods 
+
+    // Computes circuit length from traversing the passed-in points (of
+    // any BasicPoint type) in the order specified by this object.
+    template <typename P>
+    void computeCircuitLength(const vector<P> &points) {
+        this->circuitLength = orderLength(this->order.data(),
+                                          this->order.size(), points);
+    }
+
+    // Same as above, but looks the distances up in a precomputed matrix.
+    void computeCircuitLength(const DistanceMatrix &dist) {
+        this->circuitLength = orderLength(this->order.data(),
+                                          this->order.size(), dist);
+    }
+
+    // "Mutates" the genome by swapping two randomly-selected values in the
+    // order vector.
+    void mutate(Random &rng) {
+        // If we have less than 2 elements, we can't mutate 
+        if (this->order.size() < 2)
+            return;
+
+        int n = this->order.size();
+        int rand1 = rng.below(n);
+        int rand2 = rng.below(n);
+        while (rand2 == rand1) {
+            rand2 = rng.below(n);
+        }
+
+        assert(rand1 != rand2);
+        swap(order[rand1], order[rand2]);
+    }
+};
+
+typedef BasicTSPGenome<int> TSPGenome;
+
+
+// Generate an offspring genome by crosslinking the order vectors of 
+// two existing genomes, with crossover points drawn from >rng<. We assume
+// that these genomes are made of unique elements.
+template <typename Index>
+BasicTSPGenome<Index> *crosslink(const BasicTSPGenome<Index> &g1,
+                                 const BasicTSPGenome<Index> &g2,
+                                 Random &rng) {
+    // Sizes should be equal (same circuit length)
+    const vector<Index> &g1Order = g1.getOrder();
+    const vector<Index> &g2Order = g2.getOrder();
+    assert(g1Order.size() == g2Order.size());
+
+    unsigned int N = g1Order.size();
+    vector<Index> offspring(N);
+    CrossoverScratch scratch(N);
+    crosslinkCrossover(g1Order.data(), g2Order.data(), offspring.data(), N,
+                       scratch, rng);
+    return new BasicTSPGenome<Index>(offspring);
+}
+
+// Returns true if g1 has a shorter circuit length than g2, false otherwise.
+template <typename Index>
+bool isShorterPath(const BasicTSPGenome<Index> *g1,
+                   const BasicTSPGenome<Index> *g2) {
+    return g1->getCircuitLength() < g2->getCircuitLength();
+}
+
+
+#endif // TSP_GENOME_HH
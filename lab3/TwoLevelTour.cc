@@ -0,0 +1,285 @@
+#include "TwoLevelTour.hh"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// A segment that grows past this many times the group size, or a rank that
+// drifts past RANK_LIMIT, makes the next move rebuild the whole list.
+static const int MAX_GROWTH = 4;
+static const int RANK_LIMIT = 1 << 30;
+
+
+// (Re)builds the list from >order<, in segments of about sqrt(n) cities.
+void TwoLevelTour::build(const int *order) {
+    this->groupSize = std::max(1, (int) sqrt((double) this->n));
+    this->numSegments = (this->n + this->groupSize - 1) / this->groupSize;
+    this->unbalanced = false;
+
+    this->parent.resize(this->n);
+    this->rank.resize(this->n);
+    this->succ.resize(this->n);
+    this->pred.resize(this->n);
+    this->segments.resize(this->numSegments);
+    for (int s = 0; s < this->numSegments; s++) {
+        Segment &seg = this->segments[s];
+        int begin = s * this->groupSize;
+        int end = std::min(begin + this->groupSize, this->n);
+        seg.reversed = false;
+        seg.first = order[begin];
+        seg.last = order[end - 1];
+        seg.next = (s + 1) % this->numSegments;
+        seg.prev = (s + this->numSegments - 1) % this->numSegments;
+        seg.rank = s;
+        seg.size = end - begin;
+        for (int i = begin; i < end; i++) {
+            int c = order[i];
+            this->parent[c] = s;
+            this->rank[c] = i - begin;
+            this->succ[c] = i + 1 < end ? order[i + 1] : -1;
+            this->pred[c] = i > begin ? order[i - 1] : -1;
+        }
+    }
+}
+
+
+// Puts city >c< after the tail of segment >s<.
+void TwoLevelTour::appendCity(int s, int c) {
+    Segment &seg = this->segments[s];
+    if (!seg.reversed) {
+        this->succ[seg.last] = c;
+        this->pred[c] = seg.last;
+        this->rank[c] = this->rank[seg.last] + 1;
+        seg.last = c;
+    }
+    else {
+        this->pred[seg.first] = c;
+        this->succ[c] = seg.first;
+        this->rank[c] = this->rank[seg.first] - 1;
+        seg.first = c;
+    }
+    this->parent[c] = s;
+    seg.size++;
+    if (seg.size > MAX_GROWTH * this->groupSize ||
+        abs(this->rank[c]) > RANK_LIMIT)
+        this->unbalanced = true;
+}
+
+
+// Puts city >c< before the head of segment >s<.
+void TwoLevelTour::prependCity(int s, int c) {
+    Segment &seg = this->segments[s];
+    if (!seg.reversed) {
+        this->pred[seg.first] = c;
+        this->succ[c] = seg.first;
+        this->rank[c] = this->rank[seg.first] - 1;
+        seg.first = c;
+    }
+    else {
+        this->succ[seg.last] = c;
+        this->pred[c] = seg.last;
+        this->rank[c] = this->rank[seg.last] + 1;
+        seg.last = c;
+    }
+    this->parent[c] = s;
+    seg.size++;
+    if (seg.size > MAX_GROWTH * this->groupSize ||
+        abs(this->rank[c]) > RANK_LIMIT)
+        this->unbalanced = true;
+}
+
+
+// Moves the first >count< cities of segment >s<, in tour order, to the end
+// of the segment before it. s keeps at least one city.
+void TwoLevelTour::moveToPrevious(int s, int count) {
+    Segment &seg = this->segments[s];
+    assert(count < seg.size);
+    for (int i = 0; i < count; i++) {
+        int c = this->head(s);
+        if (!seg.reversed)
+            seg.first = this->succ[c];
+        else
+            seg.last = this->pred[c];
+        seg.size--;
+        this->appendCity(seg.prev, c);
+    }
+}
+
+
+// Moves the last >count< cities of segment >s<, in tour order, to the
+// start of the segment after it. s keeps at least one city.
+void TwoLevelTour::moveToNext(int s, int count) {
+    Segment &seg = this->segments[s];
+    assert(count < seg.size);
+    for (int i = 0; i < count; i++) {
+        int c = this->tail(s);
+        if (!seg.reversed)
+            seg.last = this->pred[c];
+        else
+            seg.first = this->succ[c];
+        seg.size--;
+        this->prependCity(seg.next, c);
+    }
+}
+
+
+// Makes >c< the head of a segment, by moving the smaller side of its
+// segment into the neighbouring one.
+void TwoLevelTour::makeHead(int c) {
+    int s = this->parent[c];
+    if (c == this->head(s))
+        return;
+    int before = abs(this->rank[c] - this->rank[this->head(s)]);
+    if (2 * before <= this->segments[s].size)
+        this->moveToPrevious(s, before);
+    else
+        this->moveToNext(s, this->segments[s].size - before);
+}
+
+
+// Makes >c< the tail of a segment, like makeHead, without putting cities
+// in front of the head of segment >keep<.
+void TwoLevelTour::makeTail(int c, int keep) {
+    int s = this->parent[c];
+    if (c == this->tail(s))
+        return;
+    int after = abs(this->rank[this->tail(s)] - this->rank[c]);
+    if (2 * after <= this->segments[s].size &&
+        this->segments[s].next != keep)
+        this->moveToNext(s, after);
+    else
+        this->moveToPrevious(s, this->segments[s].size - after);
+}
+
+
+// Reverses the path x..y (forwards), which lies within one segment.
+void TwoLevelTour::reverseInSegment(int x, int y) {
+    int s = this->parent[x];
+    Segment &seg = this->segments[s];
+    if (x == this->head(s) && y == this->tail(s)) {
+        seg.reversed = !seg.reversed;
+        return;
+    }
+
+    // u..v is the path along the city links.
+    int u = seg.reversed ? y : x;
+    int v = seg.reversed ? x : y;
+    bool atFirst = u == seg.first;
+    bool atLast = v == seg.last;
+    int before = this->pred[u];
+    int after = this->succ[v];
+    int r = this->rank[u];
+
+    this->scratch.clear();
+    for (int c = u; ; c = this->succ[c]) {
+        this->scratch.push_back(c);
+        if (c == v)
+            break;
+    }
+
+    int len = this->scratch.size();
+    for (int i = 0; i < len; i++) {
+        int c = this->scratch[len - 1 - i];
+        this->rank[c] = r + i;
+        this->pred[c] = i == 0 ? before : this->scratch[len - i];
+        this->succ[c] = i == len - 1 ? after : this->scratch[len - 2 - i];
+    }
+    if (atFirst)
+        seg.first = v;
+    else
+        this->succ[before] = v;
+    if (atLast)
+        seg.last = u;
+    else
+        this->pred[after] = u;
+}
+
+
+// Reverses the run of segments from >from< forwards to >to<: their order
+// is reversed and each one's reversed bit flips.
+void TwoLevelTour::reverseSegments(int from, int to) {
+    this->scratch.clear();
+    for (int s = from; ; s = this->segments[s].next) {
+        this->scratch.push_back(s);
+        if (s == to)
+            break;
+    }
+
+    int len = this->scratch.size();
+    int before = this->segments[from].prev;
+    int after = this->segments[to].next;
+    bool whole = len == this->numSegments;
+
+    // The run takes over its own ranks, in reverse.
+    for (int i = 0; i < len / 2; i++) {
+        Segment &a = this->segments[this->scratch[i]];
+        Segment &b = this->segments[this->scratch[len - 1 - i]];
+        std::swap(a.rank, b.rank);
+    }
+    for (int i = 0; i < len; i++) {
+        Segment &seg = this->segments[this->scratch[i]];
+        seg.reversed = !seg.reversed;
+        if (whole) {
+            seg.next = this->scratch[(i + len - 1) % len];
+            seg.prev = this->scratch[(i + 1) % len];
+        }
+        else {
+            seg.next = i == 0 ? after : this->scratch[i - 1];
+            seg.prev = i == len - 1 ? before : this->scratch[i + 1];
+        }
+    }
+    if (!whole) {
+        this->segments[before].next = to;
+        this->segments[after].prev = from;
+    }
+}
+
+
+// Reverses the path x..y (forwards).
+void TwoLevelTour::reversePath(int x, int y) {
+    for (;;) {
+        if (this->parent[x] == this->parent[y]) {
+            if (this->inSegmentOrder(x, y)) {
+                this->reverseInSegment(x, y);
+            }
+            else if (this->next(y) != x) {
+                // The path wraps around the whole tour; its complement is
+                // inside the segment, and reversing that gives the same
+                // tour.
+                this->reverseInSegment(this->next(y), this->prev(x));
+            }
+            return;
+        }
+
+        this->makeHead(x);
+        if (this->parent[x] == this->parent[y])
+            continue;
+        this->makeTail(y, this->parent[x]);
+        if (this->parent[x] == this->parent[y])
+            continue;
+        this->reverseSegments(this->parent[x], this->parent[y]);
+        return;
+    }
+}
+
+
+/*
+ * Replaces edges (a, b) and (c, d), where b = next(a) and d = next(c),
+ * with (a, c) and (b, d). Either the path b..c or the path d..a has to be
+ * reversed; the one over fewer segments is.
+ */
+void TwoLevelTour::twoOptMove(int a, int b, int c, int d) {
+    assert(this->next(a) == b && this->next(c) == d);
+    int sb = this->segments[this->parent[b]].rank;
+    int sc = this->segments[this->parent[c]].rank;
+    int inside = (sc - sb + this->numSegments) % this->numSegments + 1;
+    if (this->parent[b] != this->parent[c] &&
+        2 * inside > this->numSegments)
+        this->reversePath(d, a);
+    else
+        this->reversePath(b, c);
+
+    if (this->unbalanced) {
+        this->toOrder(this->scratch);
+        this->build(this->scratch.data());
+    }
+}
@@ -0,0 +1,175 @@
+#ifndef TWO_LEVEL_TOUR_HH
+#define TWO_LEVEL_TOUR_HH
+
+#include <cassert>
+#include <vector>
+using namespace std;
+
+
+// A tour stored as a two-level doubly-linked list (Fredman et al.): the
+// cities are cut into about sqrt(n) segments, each a doubly-linked list of
+// its cities with a reversed bit, and the segments are themselves linked
+// in tour order. next, prev and between are O(1); a 2-opt move splits at
+// most two segments and reverses the run of segments between them by
+// flipping their bits, so it costs O(sqrt n) where ArrayTour's costs O(n).
+//
+// It offers the same moves as ArrayTour, but keeps its own copy of the
+// tour: it is built from an order vector and written back with toOrder.
+// All links are indices into flat arrays, one entry per city or segment,
+// so assigning a new tour of the same size reuses them without
+// allocating.
+class TwoLevelTour {
+
+private:
+    struct Segment {
+        bool reversed;      // tour order is last..first rather than
+                            // first..last
+        int first;          // ends of the city list, by the city links
+        int last;
+        int next;           // neighbouring segments in tour order
+        int prev;
+        int rank;           // increases along the tour, wrapping once
+        int size;
+    };
+
+    int n;
+    int groupSize;          // cities per segment when (re)built
+    int numSegments;
+
+    // Per city. succ and pred link a city to its neighbours in its segment
+    // (ignoring the reversed bit); rank increases along those links and is
+    // contiguous within a segment. The links of a segment's end cities
+    // that point out of the segment are never read.
+    vector<int> parent;
+    vector<int> rank;
+    vector<int> succ;
+    vector<int> pred;
+    vector<Segment> segments;
+
+    vector<int> scratch;
+    bool unbalanced;        // a segment grew too large; rebuild
+
+    void build(const int *order);
+
+    int head(int s) const {
+        return segments[s].reversed ? segments[s].last : segments[s].first;
+    }
+
+    int tail(int s) const {
+        return segments[s].reversed ? segments[s].first : segments[s].last;
+    }
+
+    // True if city a does not come after city b in their segment.
+    bool inSegmentOrder(int a, int b) const {
+        return segments[parent[a]].reversed ? rank[a] >= rank[b]
+                                            : rank[a] <= rank[b];
+    }
+
+    // True if city a comes before city b, counting from the segment of
+    // rank 0.
+    bool before(int a, int b) const {
+        int sa = segments[parent[a]].rank;
+        int sb = segments[parent[b]].rank;
+        if (sa != sb)
+            return sa < sb;
+        return a != b && inSegmentOrder(a, b);
+    }
+
+    void makeHead(int c);
+    void makeTail(int c, int keep);
+    void moveToPrevious(int s, int count);
+    void moveToNext(int s, int count);
+    void appendCity(int s, int c);
+    void prependCity(int s, int c);
+    void reverseInSegment(int x, int y);
+    void reverseSegments(int from, int to);
+    void reversePath(int x, int y);
+
+public:
+    // Constructors
+    TwoLevelTour() : n(0), groupSize(1), numSegments(0), unbalanced(false) {}
+
+    template <typename Index>
+    TwoLevelTour(const vector<Index> &order) {
+        assign(order);
+    }
+
+    // Replaces the tour with >order<.
+    template <typename Index>
+    void assign(const vector<Index> &order) {
+        n = order.size();
+        scratch.assign(order.begin(), order.end());
+        build(scratch.data());
+    }
+
+    // Writes the tour to >order<, starting at some city and in some
+    // direction; each order gives the same tour.
+    template <typename Index>
+    void toOrder(vector<Index> &order) const {
+        order.resize(n);
+        if (n == 0)
+            return;
+        int c = head(0);
+        for (int i = 0; i < n; i++) {
+            order[i] = (Index) c;
+            c = next(c);
+        }
+    }
+
+    // Accessor methods
+    int size() const {
+        return n;
+    }
+
+    int next(int c) const {
+        int s = parent[c];
+        if (c == tail(s))
+            return head(segments[s].next);
+        return segments[s].reversed ? pred[c] : succ[c];
+    }
+
+    int prev(int c) const {
+        int s = parent[c];
+        if (c == head(s))
+            return tail(segments[s].prev);
+        return segments[s].reversed ? succ[c] : pred[c];
+    }
+
+    // True if b lies on the path from a forwards to c (inclusive).
+    bool between(int a, int b, int c) const {
+        if (!before(c, a))
+            return !before(b, a) && !before(c, b);
+        return !before(b, a) || !before(c, b);
+    }
+
+    // Other methods
+    void twoOptMove(int a, int b, int c, int d);
+
+    /*
+     * Replaces edges {a, b} and {c, d} with {a, c} and {b, d}, where b and d
+     * follow a and c in the same direction, whichever that is.
+     */
+    void exchange(int a, int b, int c, int d) {
+        if (next(a) == b)
+            twoOptMove(a, b, c, d);
+        else
+            twoOptMove(b, a, d, c);
+    }
+
+    /*
+     * Moves the segment s1..s2 (forwards) between x and y = next(x), either
+     * as x s1..s2 y or, if >reversed<, as x s2..s1 y, as ArrayTour does.
+     */
+    void moveSegment(int s1, int s2, int x, int y, bool reversed) {
+        int p = prev(s1);
+        int q = next(s2);
+        exchange(p, s1, x, y);      // p x ... q s2 .. s1 y
+        if (x != q)
+            exchange(p, x, q, s2);  // p q ... x s2 .. s1 y
+        if (!reversed)
+            exchange(x, s2, s1, y);
+    }
+};
+
+
+#endif // TWO_LEVEL_TOUR_HH
@@ -0,0 +1,364 @@
+#include "aco.hh"
+#include "Population.hh"
+#include "ThreadPool.hh"
+#include "construct.hh"
+#include "local-search.hh"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <thread>
+using namespace std;
+
+// Candidate edges shorter than this count as this long, so duplicate
+// points do not get an infinite heuristic value.
+static const double MIN_DISTANCE = 1e-9;
+
+
+// One ant: its own random stream, the tour it builds and the scratch space
+// for building it, reused every iteration.
+struct Ant {
+    Random rng;
+    vector<int> order;
+    vector<int> unvisited;      // compact; visited cities are swapped out
+    vector<int> slot;           // index in unvisited, or -1 once visited
+    vector<double> weights;     // one per candidate edge of the current city
+    LocalSearchScratch search;
+    double length;
+};
+
+
+// State of one colonyAShortPath run.
+//
+// Pheromone is only kept on candidate edges: row i of the n x k tables
+// belongs to the edges from city i to its k nearest neighbours, in the
+// order NeighbourLists gives them. An edge (i, j) with j a candidate of i
+// and i a candidate of j has an entry in both rows, and both are always
+// updated together. Other edges are only ever taken when every candidate
+// of a city has been visited, and then the nearest unvisited city is.
+class Colony {
+
+private:
+    const DistanceMatrix &dist;
+    const NeighbourLists &neighbours;
+    const ACOOptions &options;
+    int n;
+    int k;
+
+    vector<double> pheromone;   // n x k, trail on each candidate edge
+    vector<double> heuristic;   // n x k, (1 / distance)^beta
+    vector<double> choice;      // n x k, pheromone^alpha * heuristic
+    double trailMin;
+    double trailMax;
+
+    vector<int> best;
+    double bestLength;
+
+    // Picks the city the ant at >current< moves to: one of the unvisited
+    // candidates of >current<, with odds in proportion to their choice
+    // values, or failing that the nearest unvisited city.
+    int nextCity(Ant &ant, int current) {
+        const int *cand = this->neighbours.of(current);
+        const double *row = &this->choice[(size_t) current * this->k];
+        double total = 0;
+        for (int r = 0; r < this->k; r++) {
+            double w = ant.slot[cand[r]] >= 0 ? row[r] : 0;
+            ant.weights[r] = w;
+            total += w;
+        }
+
+        if (total > 0) {
+            double x = ant.rng.uniform() * total;
+            int last = -1;
+            for (int r = 0; r < this->k; r++) {
+                if (ant.weights[r] <= 0)
+                    continue;
+                last = r;
+                x -= ant.weights[r];
+                if (x < 0)
+                    return cand[r];
+            }
+            // Rounding left x just above 0.
+            return cand[last];
+        }
+
+        int nearest = ant.unvisited[0];
+        double nearestDist = this->dist(current, nearest);
+        for (int c : ant.unvisited) {
+            double d = this->dist(current, c);
+            if (d < nearestDist) {
+                nearest = c;
+                nearestDist = d;
+            }
+        }
+        return nearest;
+    }
+
+    // Builds a new tour for >ant< from a random city.
+    void buildTour(Ant &ant) {
+        ant.order.clear();
+        ant.unvisited.resize(this->n);
+        for (int i = 0; i < this->n; i++) {
+            ant.unvisited[i] = i;
+            ant.slot[i] = i;
+        }
+        auto visit = [&](int c) {
+            int last = ant.unvisited.back();
+            ant.unvisited[ant.slot[c]] = last;
+            ant.slot[last] = ant.slot[c];
+            ant.unvisited.pop_back();
+            ant.slot[c] = -1;
+            ant.order.push_back(c);
+        };
+
+        int current = ant.rng.below(this->n);
+        visit(current);
+        while (!ant.unvisited.empty()) {
+            current = this->nextCity(ant, current);
+            visit(current);
+        }
+    }
+
+    // Sets the trail limits from the best length so far (Stuetzle and
+    // Hoos): the highest trail is what the best tour's edges converge to,
+    // and the lowest gives a converged colony odds of pBest of building it.
+    void setTrailLimits() {
+        this->trailMax = 1 / (this->options.evaporation * this->bestLength);
+        double root = pow(this->options.pBest, 1.0 / this->n);
+        double choices = std::max(this->k / 2.0, 2.0);
+        this->trailMin = this->trailMax * (1 - root) / ((choices - 1) * root);
+        this->trailMin = std::min(this->trailMin, this->trailMax);
+    }
+
+    // Adds >amount< to the trail on edge (a, b) in the row of a, if b is a
+    // candidate of a.
+    void addTrail(int a, int b, double amount) {
+        const int *cand = this->neighbours.of(a);
+        for (int r = 0; r < this->k; r++) {
+            if (cand[r] == b) {
+                this->pheromone[(size_t) a * this->k + r] += amount;
+                return;
+            }
+        }
+    }
+
+    /*
+     * Evaporates every trail, lets >order< lay pheromone on its edges and
+     * recomputes the choice values. The passes over all n * k entries are
+     * plain loops over contiguous arrays, which the compiler vectorizes;
+     * only the deposit, n edges long, is scattered.
+     */
+    void updateTrails(const vector<int> &order, double length) {
+        size_t size = this->pheromone.size();
+        double *trail = this->pheromone.data();
+        double keep = 1 - this->options.evaporation;
+        for (size_t i = 0; i < size; i++)
+            trail[i] *= keep;
+
+        double amount = 1 / length;
+        for (int i = 0; i < this->n; i++) {
+            int a = order[i];
+            int b = order[i + 1 == this->n ? 0 : i + 1];
+            this->addTrail(a, b, amount);
+            this->addTrail(b, a, amount);
+        }
+
+        double lo = this->trailMin;
+        double hi = this->trailMax;
+        for (size_t i = 0; i < size; i++)
+            trail[i] = std::min(std::max(trail[i], lo), hi);
+        this->computeChoice();
+    }
+
+    // Recomputes choice from pheromone and heuristic.
+    void computeChoice() {
+        size_t size = this->pheromone.size();
+        const double *trail = this->pheromone.data();
+        const double *eta = this->heuristic.data();
+        double *out = this->choice.data();
+        if (this->options.alpha == 1) {
+            for (size_t i = 0; i < size; i++)
+                out[i] = trail[i] * eta[i];
+        }
+        else {
+            for (size_t i = 0; i < size; i++)
+                out[i] = pow(trail[i], this->options.alpha) * eta[i];
+        }
+    }
+
+    // Sets every trail to the highest level.
+    void resetTrails() {
+        std::fill(this->pheromone.begin(), this->pheromone.end(),
+                  this->trailMax);
+        this->computeChoice();
+    }
+
+public:
+    // Starts from a nearest-neighbour tour, which sets the first trail
+    // limits; all trails start at the highest level.
+    Colony(const DistanceMatrix &dist, const NeighbourLists &neighbours,
+           const ACOOptions &options)
+        : dist(dist), neighbours(neighbours), options(options),
+          n(dist.size()), k(neighbours.getK()) {
+        size_t size = (size_t) this->n * this->k;
+        this->pheromone.resize(size);
+        this->heuristic.resize(size);
+        this->choice.resize(size);
+        for (int i = 0; i < this->n; i++) {
+            const int *cand = neighbours.of(i);
+            for (int r = 0; r < this->k; r++) {
+                double d = std::max(dist(i, cand[r]), MIN_DISTANCE);
+                this->heuristic[(size_t) i * this->k + r] =
+                    pow(1 / d, options.beta);
+            }
+        }
+
+        this->best = nearestNeighbourTour(dist, neighbours, 0);
+        this->bestLength = orderLength(this->best.data(), this->n, dist);
+        this->setTrailLimits();
+        this->resetTrails();
+    }
+
+    const vector<int> &getBest() const {
+        return this->best;
+    }
+
+    double getBestLength() const {
+        return this->bestLength;
+    }
+
+    /*
+     * Runs >numIterations< iterations of >ants.size()< ants. The ants of an
+     * iteration build their tours side by side on >pool<; each ant keeps
+     * its own random stream, so the run does not depend on how many
+     * threads there are.
+     */
+    void run(vector<Ant> &ants, int numIterations, ThreadPool &pool) {
+        for (Ant &ant : ants) {
+            ant.slot.resize(this->n);
+            ant.weights.resize(this->k);
+        }
+
+        LocalSearchOptions search;
+        int lastImprovement = 0;
+        for (int it = 0; it < numIterations; it++) {
+            pool.parallelFor(0, ants.size(), 1, [&](size_t lo, size_t hi) {
+                for (size_t a = lo; a < hi; a++) {
+                    Ant &ant = ants[a];
+                    this->buildTour(ant);
+                    if (this->options.localSearch) {
+                        improveTour(ant.order, this->dist, this->neighbours,
+                                    search, ant.search);
+                    }
+                    ant.length = orderLength(ant.order.data(), this->n,
+                                             this->dist);
+                }
+            });
+
+            // Ties go to the lowest ant, so the result is reproducible.
+            size_t iterationBest = 0;
+            for (size_t a = 1; a < ants.size(); a++) {
+                if (ants[a].length < ants[iterationBest].length)
+                    iterationBest = a;
+            }
+            const Ant &winner = ants[iterationBest];
+            if (winner.length < this->bestLength) {
+                this->best = winner.order;
+                this->bestLength = winner.length;
+                this->setTrailLimits();
+                lastImprovement = it;
+            }
+
+            if (this->options.restartInterval > 0 &&
+                it - lastImprovement >= this->options.restartInterval) {
+                this->resetTrails();
+                lastImprovement = it;
+            }
+            else if (this->options.bestSoFarInterval > 0 &&
+                     (it + 1) % this->options.bestSoFarInterval == 0) {
+                this->updateTrails(this->best, this->bestLength);
+            }
+            else {
+                this->updateTrails(winner.order, winner.length);
+            }
+
+            // Print stuff to see what's going on.
+            if (this->options.verbose && it % 10 == 0) {
+                cout << "Iteration " << it << ": shortest path is "
+                     << this->bestLength << "\n";
+            }
+        }
+    }
+};
+
+
+// Runs colonyAShortPath on >dist<, with >neighbours< as the candidate
+// lists.
+static TSPGenome *runColony(const DistanceMatrix &dist,
+                           const NeighbourLists &neighbours, int numAnts,
+                           int numIterations, const ACOOptions &options) {
+    TSPGenome *result;
+    if (dist.size() < 4) {
+        // Every tour is as long as any other.
+        vector<int> order(dist.size());
+        for (unsigned int i = 0; i < dist.size(); i++)
+            order[i] = i;
+        result = new TSPGenome(order);
+    }
+    else {
+        Colony colony(dist, neighbours, options);
+        vector<Ant> ants(numAnts);
+        Random seedStream(options.seed);
+        for (int a = 0; a < numAnts; a++)
+            ants[a].rng = seedStream.nextStream();
+
+        unsigned int numThreads = options.numThreads == 0 ?
+            thread::hardware_concurrency() : options.numThreads;
+        ThreadPool pool(std::min(numThreads, (unsigned int) numAnts));
+        colony.run(ants, numIterations, pool);
+        result = new TSPGenome(colony.getBest());
+    }
+
+    result->computeCircuitLength(dist);
+    return result;
+}
+
+
+/*
+ * Finds a short path with a MAX-MIN ant system, as an alternative to the
+ * GA in findAShortPath. Every iteration, >numAnts< ants each build a tour
+ * city by city, choosing among the nearest unvisited candidates with odds
+ * in proportion to pheromone^alpha * (1 / distance)^beta. Then all trails
+ * evaporate, and one tour lays pheromone on its edges: mostly the best of
+ * the iteration, sometimes the best so far. Trails are kept between a
+ * lowest and a highest level, so no edge is ever ruled out, and they are
+ * reset once the run stops improving.
+ *
+ * Pheromone is only stored for the candidate edges of each city, so the
+ * colony takes O(nk) memory beyond the distance matrix, which is not kept
+ * for large instances.
+ */
+TSPGenome *colonyAShortPath(const vector<Point> &points, int numAnts,
+                            int numIterations, const ACOOptions &options) {
+    assert(points.size() > 0 && numAnts > 0 && numIterations >= 0);
+
+    unsigned int maxCachedPoints = DEFAULT_MAX_CACHED_POINTS;
+    if (options.largeInstance)
+        maxCachedPoints = 0;
+    DistanceMatrix dist(points, MatrixLayout::FULL, maxCachedPoints);
+    NeighbourLists neighbours(points, std::max(options.numNeighbours, 1),
+                              options.numThreads);
+    return runColony(dist, neighbours, numAnts, numIterations, options);
+}
+
+
+// Same, for cities known only by the distances in >dist<, such as TSPLIB
+// GEO and EXPLICIT instances. The candidate lists are found by scanning
+// the matrix.
+TSPGenome *colonyAShortPath(const DistanceMatrix &dist, int numAnts,
+                            int numIterations, const ACOOptions &options) {
+    assert(dist.size() > 0 && numAnts > 0 && numIterations >= 0);
+
+    NeighbourLists neighbours(dist, std::max(options.numNeighbours, 1));
+    return runColony(dist, neighbours, numAnts, numIterations, options);
+}
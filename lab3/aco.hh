@@ -0,0 +1,41 @@
+#ifndef ACO_HH
+#define ACO_HH
+
+#include "TSPGenome.hh"
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+
+// Settings for colonyAShortPath, a MAX-MIN ant system. The defaults follow
+// Stuetzle and Hoos for runs with local search.
+struct ACOOptions {
+    bool verbose = true;        // print the best length every 10 iterations
+    unsigned int numThreads = 0;    // threads building tours (0 = all)
+    uint64_t seed = 0;          // the same seed replays the same run
+    int numNeighbours = 20;     // candidate edges per city, with pheromone
+    double alpha = 1;           // weight of the pheromone
+    double beta = 2;            // weight of 1 / distance
+    double evaporation = 0.2;   // share of the pheromone lost per iteration
+    double pBest = 0.05;        // odds of a converged colony building the
+                                // best tour, which sets the lowest trail
+    // Every bestSoFarInterval-th iteration the best tour found so far lays
+    // pheromone; the other iterations, the best one of the iteration does.
+    int bestSoFarInterval = 10;
+    // After this many iterations without a better tour, all trails are
+    // reset to the highest level (0 = never).
+    int restartInterval = 250;
+    bool localSearch = true;    // polish every ant's tour with 2-opt and
+                                // Or-opt before it lays pheromone
+    bool largeInstance = false; // never tabulate distances, however few
+};
+
+TSPGenome *colonyAShortPath(const vector<Point> &points, int numAnts,
+                            int numIterations,
+                            const ACOOptions &options = ACOOptions());
+TSPGenome *colonyAShortPath(const DistanceMatrix &dist, int numAnts,
+                            int numIterations,
+                            const ACOOptions &options = ACOOptions());
+
+
+#endif // ACO_HH
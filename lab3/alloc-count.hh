@@ -0,0 +1,20 @@
+#ifndef ALLOC_COUNT_HH
+#define ALLOC_COUNT_HH
+
+#include <cstdint>
+using namespace std;
+
+
+// Counting heap allocations replaces the global operator new and delete,
+// so it lives in its own object file: only binaries that link
+// alloc-count.o pay for it, and the rest keep the default allocators.
+
+// Turns allocation counting on or off for the whole process.
+void countAllocations(bool on);
+
+// Returns the number of heap allocations the calling thread has made while
+// counting was on.
+uint64_t allocationCount();
+
+
+#endif // ALLOC_COUNT_HH
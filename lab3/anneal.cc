@@ -0,0 +1,326 @@
+#include "anneal.hh"
+#include "ArrayTour.hh"
+#include "Population.hh"
+#include "ThreadPool.hh"
+#include "local-search.hh"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <thread>
+using namespace std;
+
+// The temperature is recomputed every TEMPERATURE_STEP moves. The initial
+// temperature, unless given, comes from SAMPLE_MOVES proposed moves: the
+// average uphill one is accepted half the time.
+static const int TEMPERATURE_STEP = 100;
+static const int SAMPLE_MOVES = 1000;
+static const double FINAL_TEMPERATURE_RATIO = 1e-3;
+
+
+// Returns the temperature after >progress< (0 to 1) of the run.
+static double temperature(Cooling cooling, double initial, double final,
+                          double progress) {
+    switch (cooling) {
+    case Cooling::LINEAR:
+        return initial + (final - initial) * progress;
+    case Cooling::LUNDY_MEES:
+        return 1 / (1 / initial + (1 / final - 1 / initial) * progress);
+    default:
+        return initial * pow(final / initial, progress);
+    }
+}
+
+
+enum class MoveType {
+    TWO_OPT,        // exchange(a, b, c, d)
+    SWAP,           // swapCities(a, c)
+    INSERTION       // city a moved between c and d = next(c)
+};
+
+struct Move {
+    MoveType type;
+    int a, b, c, d;
+};
+
+
+// State of one annealing run, from a random tour.
+class Annealer {
+
+private:
+    const DistanceMatrix &dist;
+    const NeighbourLists *neighbours;
+    const SAOptions &options;
+    Random rng;
+    int n;
+    vector<int> order;
+    ArrayTour tour;
+
+    double d(int a, int b) const {
+        return dist(a, b);
+    }
+
+    // A random city other than >a<, one of its candidate neighbours if
+    // there are any.
+    int partnerOf(int a) {
+        if (neighbours && neighbours->getK() > 0)
+            return neighbours->of(a)[rng.below(neighbours->getK())];
+        int c = rng.below(n - 1);
+        return c >= a ? c + 1 : c;
+    }
+
+    /*
+     * Picks a random move and returns how much it would change the tour
+     * length, without making it. Every move type only changes two or three
+     * edges, so this is O(1). Returns false if the move drawn is not a
+     * move at all (for instance, a city swapped with itself).
+     */
+    bool propose(Move &m, double &delta) {
+        m.a = rng.below(n);
+        m.c = partnerOf(m.a);
+        double kind = rng.uniform();
+        bool forward = rng.below(2) == 0;
+
+        if (kind < options.twoOptShare) {
+            // Adds the edge (a, c), in either tour direction.
+            m.type = MoveType::TWO_OPT;
+            m.b = forward ? tour.next(m.a) : tour.prev(m.a);
+            m.d = forward ? tour.next(m.c) : tour.prev(m.c);
+            if (m.c == m.b || m.d == m.a)
+                return false;
+            delta = d(m.a, m.c) + d(m.b, m.d) - d(m.a, m.b) - d(m.c, m.d);
+            return true;
+        }
+
+        int pa = tour.prev(m.a);
+        int na = tour.next(m.a);
+        if (kind < options.twoOptShare + options.swapShare) {
+            m.type = MoveType::SWAP;
+            int pc = tour.prev(m.c);
+            int nc = tour.next(m.c);
+            if (na == m.c)
+                delta = d(pa, m.c) + d(m.a, nc) - d(pa, m.a) - d(m.c, nc);
+            else if (nc == m.a)
+                delta = d(pc, m.a) + d(m.c, na) - d(pc, m.c) - d(m.a, na);
+            else
+                delta = d(pa, m.c) + d(m.c, na) + d(pc, m.a) + d(m.a, nc) -
+                        d(pa, m.a) - d(m.a, na) - d(pc, m.c) - d(m.c, nc);
+            return true;
+        }
+
+        // Puts a next to c, on either side of it.
+        m.type = MoveType::INSERTION;
+        if (!forward)
+            m.c = tour.prev(m.c);
+        m.d = tour.next(m.c);
+        if (m.c == m.a || m.d == m.a || m.c == pa || m.d == pa)
+            return false;
+        delta = d(pa, na) - d(pa, m.a) - d(m.a, na) +
+                d(m.c, m.a) + d(m.a, m.d) - d(m.c, m.d);
+        return true;
+    }
+
+    void apply(const Move &m) {
+        switch (m.type) {
+        case MoveType::TWO_OPT:
+            tour.exchange(m.a, m.b, m.c, m.d);
+            break;
+        case MoveType::SWAP:
+            tour.swapCities(m.a, m.c);
+            break;
+        case MoveType::INSERTION:
+            tour.moveSegment(m.a, m.a, m.c, m.d, true);
+            break;
+        }
+    }
+
+    // Sets the temperature at which the average uphill move drawn from the
+    // starting tour has even odds of being accepted.
+    double sampleTemperature() {
+        double uphill = 0;
+        int numUphill = 0;
+        for (int i = 0; i < SAMPLE_MOVES; i++) {
+            Move m;
+            double delta;
+            if (propose(m, delta) && delta > 0) {
+                uphill += delta;
+                numUphill++;
+            }
+        }
+        if (numUphill == 0)
+            return 1;
+        return uphill / numUphill / log(2.0);
+    }
+
+    double length() const {
+        return orderLength(order.data(), n, dist);
+    }
+
+    static vector<int> randomTour(int n, Random &rng) {
+        vector<int> order(n);
+        randomOrder(order.data(), n, rng);
+        return order;
+    }
+
+public:
+    Annealer(const DistanceMatrix &dist, const NeighbourLists *neighbours,
+             const SAOptions &options, const Random &rng)
+        : dist(dist), neighbours(neighbours), options(options), rng(rng),
+          n(dist.size()), order(randomTour(n, this->rng)), tour(order) {
+    }
+
+    /*
+     * Anneals for >numMoves< moves and copies the shortest tour seen to
+     * >best<, returning its length. The tour is checked against the best
+     * about every n moves (a copy costs O(n)), and at the end. With
+     * >verbose<, prints the state of the run every tenth of it.
+     */
+    double run(long long numMoves, bool verbose, vector<int> &best) {
+        best = order;
+        double bestLength = length();
+        if (n < 5)
+            return bestLength;
+
+        double initial = options.initialTemperature;
+        if (initial <= 0)
+            initial = sampleTemperature();
+        double final = options.finalTemperature;
+        if (final <= 0)
+            final = initial * FINAL_TEMPERATURE_RATIO;
+
+        double current = bestLength;
+        long long sinceCheck = 0;
+        long long tenth = std::max(numMoves / 10, 1LL);
+        long long nextReport = 0;
+        for (long long done = 0; done < numMoves; ) {
+            double t = temperature(options.cooling, initial, final,
+                                   (double) done / numMoves);
+            long long stepEnd = std::min(done + TEMPERATURE_STEP, numMoves);
+            for (; done < stepEnd; done++) {
+                Move m;
+                double delta;
+                if (!propose(m, delta))
+                    continue;
+                if (delta <= 0 || rng.uniform() < exp(-delta / t)) {
+                    apply(m);
+                    current += delta;
+                }
+            }
+
+            sinceCheck += TEMPERATURE_STEP;
+            if (sinceCheck >= n || done == numMoves) {
+                // Recomputed, so rounding errors in the deltas never add
+                // up.
+                sinceCheck = 0;
+                current = length();
+                if (current < bestLength) {
+                    bestLength = current;
+                    best = order;
+                }
+            }
+
+            if (verbose && done >= nextReport) {
+                cout << "Move " << done << ": temperature " << t
+                     << ", length " << current << "\n";
+                nextReport = (done / tenth + 1) * tenth;
+            }
+        }
+        return bestLength;
+    }
+};
+
+
+// Runs the restarts of annealAShortPath on >dist<, with >neighbours< as
+// the candidate lists (or null to connect any two cities).
+static TSPGenome *anneal(const DistanceMatrix &dist,
+                         const NeighbourLists *neighbours, long long numMoves,
+                         const SAOptions &options) {
+    unsigned int numRestarts = std::max(options.numRestarts, 1u);
+    vector<vector<int>> orders(numRestarts);
+    vector<double> lengths(numRestarts);
+    Random seedStream(options.seed);
+    {
+        ThreadPool pool(std::min(options.numThreads == 0 ?
+                                 thread::hardware_concurrency() :
+                                 options.numThreads, numRestarts));
+        for (unsigned int k = 0; k < numRestarts; k++) {
+            Random rng = seedStream.nextStream();
+            pool.submit([&, k, rng]() {
+                Annealer annealer(dist, neighbours, options, rng);
+                bool verbose = options.verbose && k == 0;
+                lengths[k] = annealer.run(numMoves, verbose, orders[k]);
+            });
+        }
+        pool.wait();
+    }
+
+    if (options.verbose && numRestarts > 1) {
+        for (unsigned int k = 0; k < numRestarts; k++)
+            cout << "Restart " << k << ": shortest path is " << lengths[k]
+                 << "\n";
+    }
+
+    // Ties go to the lowest restart, so the result is reproducible.
+    unsigned int best = 0;
+    for (unsigned int k = 1; k < numRestarts; k++) {
+        if (lengths[k] < lengths[best])
+            best = k;
+    }
+
+    TSPGenome *result = new TSPGenome(orders[best]);
+    result->computeCircuitLength(dist);
+    return result;
+}
+
+
+/*
+ * Finds a short path by simulated annealing, as an alternative to the GA
+ * in findAShortPath. Each restart starts from its own random tour and
+ * makes >numMoves< moves, picked at random among 2-opt moves, swaps of two
+ * cities and insertions of one city elsewhere. A move is accepted if it
+ * does not lengthen the tour, or otherwise with probability exp(-delta /
+ * T), where the temperature T falls from the initial to the final one as
+ * the cooling schedule says.
+ *
+ * Moves are evaluated by the edges they change, in O(1); only accepted
+ * ones are made. With candidate lists every move joins a city to one of
+ * its nearest neighbours, which spends far fewer moves on hopeless
+ * long edges.
+ *
+ * The restarts run independently on a pool of threads and the shortest
+ * tour is kept. Restart k draws from stream k of the seed, so the result
+ * does not depend on the number of threads.
+ */
+TSPGenome *annealAShortPath(const vector<Point> &points, long long numMoves,
+                            const SAOptions &options) {
+    assert(points.size() > 0 && numMoves >= 0);
+
+    unsigned int maxCachedPoints = DEFAULT_MAX_CACHED_POINTS;
+    if (options.largeInstance)
+        maxCachedPoints = 0;
+    DistanceMatrix dist(points, MatrixLayout::FULL, maxCachedPoints);
+
+    NeighbourLists *neighbours = nullptr;
+    if (options.numNeighbours > 0)
+        neighbours = new NeighbourLists(points, options.numNeighbours,
+                                        options.numThreads);
+    TSPGenome *result = anneal(dist, neighbours, numMoves, options);
+    delete neighbours;
+    return result;
+}
+
+
+// Same, for cities known only by the distances in >dist<, such as TSPLIB
+// GEO and EXPLICIT instances. The candidate lists are found by scanning
+// the matrix.
+TSPGenome *annealAShortPath(const DistanceMatrix &dist, long long numMoves,
+                            const SAOptions &options) {
+    assert(dist.size() > 0 && numMoves >= 0);
+
+    NeighbourLists *neighbours = nullptr;
+    if (options.numNeighbours > 0)
+        neighbours = new NeighbourLists(dist, options.numNeighbours);
+    TSPGenome *result = anneal(dist, neighbours, numMoves, options);
+    delete neighbours;
+    return result;
+}
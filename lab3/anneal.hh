@@ -0,0 +1,40 @@
+#ifndef ANNEAL_HH
+#define ANNEAL_HH
+
+#include "TSPGenome.hh"
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+
+// How the temperature falls from the initial to the final temperature over
+// the course of an annealing run.
+enum class Cooling {
+    GEOMETRIC,      // by the same factor every step
+    LINEAR,         // by the same amount every step
+    LUNDY_MEES      // 1 / T rises by the same amount: fast, then slowly
+};
+
+// Settings for annealAShortPath.
+struct SAOptions {
+    bool verbose = true;        // print progress every tenth of the run
+    unsigned int numRestarts = 1;   // independent runs; the best is kept
+    unsigned int numThreads = 0;    // threads for the restarts (0 = all)
+    uint64_t seed = 0;          // the same seed replays the same run
+    Cooling cooling = Cooling::GEOMETRIC;
+    double initialTemperature = 0;  // 0 = from sampled move deltas
+    double finalTemperature = 0;    // 0 = a thousandth of the initial one
+    // Shares of the moves tried; the rest are insertions.
+    double twoOptShare = 0.6;
+    double swapShare = 0.1;
+    int numNeighbours = 8;      // moves connect near cities (0 = any two)
+    bool largeInstance = false; // never tabulate distances, however few
+};
+
+TSPGenome *annealAShortPath(const vector<Point> &points, long long numMoves,
+                            const SAOptions &options = SAOptions());
+TSPGenome *annealAShortPath(const DistanceMatrix &dist, long long numMoves,
+                            const SAOptions &options = SAOptions());
+
+
+#endif // ANNEAL_HH
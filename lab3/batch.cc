@@ -0,0 +1,98 @@
+#include "batch.hh"
+#include "ThreadPool.hh"
+#include "loader.hh"
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <sys/stat.h>
+using namespace std;
+
+
+/*
+ * Expands a list of instance files and directories into a list of files.
+ * Directories contribute every regular file directly inside them, in name
+ * order; other paths are passed through unchanged.
+ */
+vector<string> listInstanceFiles(const vector<string> &paths) {
+    vector<string> files;
+    for (const string &path : paths) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+            files.push_back(path);
+            continue;
+        }
+
+        vector<string> entries;
+        DIR *dir = opendir(path.c_str());
+        if (dir == nullptr)
+            continue;
+        while (struct dirent *entry = readdir(dir)) {
+            string file = path + "/" + entry->d_name;
+            if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+                entries.push_back(file);
+        }
+        closedir(dir);
+
+        std::sort(entries.begin(), entries.end());
+        files.insert(files.end(), entries.begin(), entries.end());
+    }
+    return files;
+}
+
+
+/*
+ * Solves every file in >files< with >solve<, spreading the instances over a
+ * pool of >numThreads< threads (0 means one per hardware thread). Each task
+ * reads and solves its own instance. Results come back in the order of
+ * >files<. Instances may be in the text or the binary point format.
+ */
+vector<BatchResult> runBatch(const vector<string> &files,
+                             InstanceSolver solve, unsigned int numThreads) {
+    vector<BatchResult> results(files.size());
+    ThreadPool pool(numThreads);
+
+    for (unsigned int i = 0; i < files.size(); i++) {
+        pool.submit([&, i]() {
+            BatchResult &result = results[i];
+            result.file = files[i];
+            result.ok = false;
+            result.length = 0;
+            result.seconds = 0;
+
+            vector<Point> points;
+            if (!loadPoints(files[i], points))
+                return;
+
+            auto start = chrono::steady_clock::now();
+            result.length = solve(points, result.order);
+            chrono::duration<double> elapsed =
+                chrono::steady_clock::now() - start;
+            result.seconds = elapsed.count();
+            result.ok = result.length >= 0;
+        });
+    }
+
+    pool.wait();
+    return results;
+}
+
+
+/*
+ * Writes one line per instance: the file name, then either the tour length,
+ * the wall time in seconds and the tour, or an error marker.
+ */
+void printBatchResult(ostream &os, const BatchResult &result) {
+    os << result.file;
+    if (!result.ok) {
+        os << " error" << '\n';
+        return;
+    }
+
+    os << " " << result.length << " " << result.seconds << " [";
+    for (unsigned int i = 0; i < result.order.size(); i++) {
+        os << result.order[i];
+        if (i < result.order.size() - 1)
+            os << " ";
+    }
+    os << "]" << '\n';
+}
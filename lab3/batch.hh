@@ -0,0 +1,32 @@
+#ifndef BATCH_HH
+#define BATCH_HH
+
+#include "Point.hh"
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Solves one instance: fills in >order< and returns its length, or returns
+// a negative length if the instance cannot be solved.
+typedef function<double(const vector<Point> &points, vector<int> &order)>
+    InstanceSolver;
+
+// Outcome of solving one instance file in batch mode.
+struct BatchResult {
+    string file;
+    bool ok;                // false if the file could not be read or solved
+    vector<int> order;
+    double length;
+    double seconds;         // wall time spent solving, excluding I/O
+};
+
+vector<string> listInstanceFiles(const vector<string> &paths);
+vector<BatchResult> runBatch(const vector<string> &files,
+                             InstanceSolver solve, unsigned int numThreads);
+void printBatchResult(ostream &os, const BatchResult &result);
+
+
+#endif // BATCH_HH
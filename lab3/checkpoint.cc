@@ -0,0 +1,148 @@
+#include "checkpoint.hh"
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+
+// Starts the writer thread for snapshots of the given shape. >header< gives
+// everything but the generation, which is filled in per snapshot.
+Checkpointer::Checkpointer(const string &path, const SnapshotHeader &header,
+                           size_t blockBytes)
+    : path(path), header(header), blockBytes(blockBytes), arrived(0),
+      writePending(false), stopping(false), cancelled(false),
+      failed(false) {
+    memcpy(this->header.magic, "GAS2", 4);
+    size_t total = sizeof(SnapshotHeader) + blockBytes * header.numIslands;
+    this->staging.resize(total);
+    this->writing.resize(total);
+    this->writer = thread(&Checkpointer::writerLoop, this);
+}
+
+
+Checkpointer::~Checkpointer() {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->changed.notify_all();
+    this->writer.join();
+}
+
+
+// Returns true if any snapshot could not be written.
+bool Checkpointer::hasFailed() {
+    unique_lock<mutex> guard(this->lock);
+    return this->failed;
+}
+
+
+/*
+ * Returns the block where >island< should copy its state as of
+ * >generation<. The copy itself needs no lock, as every island has its own
+ * block. An island that is a whole snapshot ahead of the others waits here
+ * until the previous snapshot has been handed to the writer. Returns null,
+ * and nothing is to be deposited, once the checkpointer is cancelled.
+ */
+char *Checkpointer::beginDeposit(int island, uint32_t generation) {
+    unique_lock<mutex> guard(this->lock);
+    this->changed.wait(guard, [&]() {
+        return this->cancelled || this->arrived == 0 ||
+               this->header.generation == generation;
+    });
+    if (this->cancelled)
+        return nullptr;
+    this->header.generation = generation;
+    return &this->staging[sizeof(SnapshotHeader) +
+                          this->blockBytes * island];
+}
+
+
+// Marks the caller's block as filled in. The last island to finish hands
+// the snapshot to the writer, waiting only if the previous one is still
+// being written.
+void Checkpointer::endDeposit() {
+    unique_lock<mutex> guard(this->lock);
+    if (++this->arrived < (int) this->header.numIslands)
+        return;
+
+    this->changed.wait(guard, [this]() { return !this->writePending; });
+    memcpy(&this->staging[0], &this->header, sizeof(SnapshotHeader));
+    this->staging.swap(this->writing);
+    this->writePending = true;
+    this->arrived = 0;
+    this->changed.notify_all();
+}
+
+
+/*
+ * Drops the snapshot being staged and refuses any more deposits, for runs
+ * that end before every island gets to the next snapshot. Islands waiting
+ * in beginDeposit are released. A snapshot already handed to the writer
+ * is still written.
+ */
+void Checkpointer::cancel() {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->cancelled = true;
+    }
+    this->changed.notify_all();
+}
+
+
+void Checkpointer::writerLoop() {
+    string temp = this->path + ".tmp";
+    while (true) {
+        {
+            unique_lock<mutex> guard(this->lock);
+            this->changed.wait(guard, [this]() {
+                return this->stopping || this->writePending;
+            });
+            if (!this->writePending)
+                return;
+        }
+
+        // The writing buffer is ours until writePending is cleared.
+        FILE *f = fopen(temp.c_str(), "wb");
+        bool ok = f != nullptr;
+        if (ok) {
+            ok = fwrite(this->writing.data(), 1, this->writing.size(), f) ==
+                 this->writing.size();
+            ok = fclose(f) == 0 && ok;
+        }
+        if (ok)
+            ok = rename(temp.c_str(), this->path.c_str()) == 0;
+
+        {
+            unique_lock<mutex> guard(this->lock);
+            this->writePending = false;
+            this->failed = this->failed || !ok;
+        }
+        this->changed.notify_all();
+    }
+}
+
+
+// Reads a snapshot written by a Checkpointer: its header, and all the
+// island blocks after it into >blocks<. Returns false if the file is
+// missing, truncated or not a snapshot.
+bool loadSnapshot(const string &path, SnapshotHeader &header,
+                  vector<char> &blocks) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              memcmp(header.magic, "GAS2", 4) == 0;
+    if (ok) {
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        ok = size >= (long) sizeof(header);
+        if (ok) {
+            blocks.resize(size - sizeof(header));
+            fseek(f, sizeof(header), SEEK_SET);
+            ok = fread(blocks.data(), 1, blocks.size(), f) == blocks.size();
+        }
+    }
+    fclose(f);
+    return ok;
+}
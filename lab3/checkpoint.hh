@@ -0,0 +1,81 @@
+#ifndef CHECKPOINT_HH
+#define CHECKPOINT_HH
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+// Header of a GA snapshot file. It is followed by one equal-sized block per
+// island, each holding the island's random state and run-control state,
+// its cached lengths and valid flags, and its order matrix, all copied
+// straight from memory. The
+// header is 32 bytes, so the blocks are suitably aligned.
+struct SnapshotHeader {
+    char magic[4];              // "GAS2"
+    uint32_t indexBytes;        // bytes per city index in the orders
+    uint32_t numCities;
+    uint32_t numIslands;
+    uint32_t populationSize;
+    uint32_t generation;        // the next generation to run
+    uint64_t seed;              // the run's seed, for reference
+};
+
+// Periodically saves the GA's state to a snapshot file without stopping
+// the GA for the disk.
+//
+// Every island copies its state into its own block of a staging buffer
+// (beginDeposit returns where). When the last island of a generation is
+// done, the staging buffer is handed to a background thread, which writes
+// the whole snapshot with one sequential write to a temporary file and
+// then renames it over the old snapshot, so a crash mid-write never
+// leaves a broken snapshot behind.
+class Checkpointer {
+
+private:
+    string path;
+    SnapshotHeader header;
+    size_t blockBytes;
+    vector<char> staging;
+    vector<char> writing;
+    int arrived;                // islands done with the staged generation
+    bool writePending;
+    bool stopping;
+    bool cancelled;
+    bool failed;
+    mutex lock;
+    condition_variable changed;
+    thread writer;
+
+    void writerLoop();
+
+public:
+    // Constructors
+    Checkpointer(const string &path, const SnapshotHeader &header,
+                 size_t blockBytes);
+
+    // Destructor - finishes any pending write, then stops the writer.
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer &) = delete;
+    Checkpointer &operator=(const Checkpointer &) = delete;
+
+    // Accessor methods
+    bool hasFailed();
+
+    // Other methods
+    char *beginDeposit(int island, uint32_t generation);
+    void endDeposit();
+    void cancel();
+};
+
+bool loadSnapshot(const string &path, SnapshotHeader &header,
+                  vector<char> &blocks);
+
+
+#endif // CHECKPOINT_HH
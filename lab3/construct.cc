@@ -0,0 +1,319 @@
+#include "construct.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+using namespace std;
+
+
+/*
+ * Builds a tour by starting at >start< and always moving to the nearest
+ * unvisited city. The nearest city is looked for in the candidate list
+ * first; only when every candidate has been visited are the remaining
+ * cities scanned.
+ */
+vector<int> nearestNeighbourTour(const DistanceMatrix &dist,
+                                 const NeighbourLists &neighbours, int start) {
+    int n = dist.size();
+    vector<int> order;
+    if (n == 0)
+        return order;
+    order.reserve(n);
+
+    // Unvisited cities, kept compact by swapping visited ones out.
+    vector<int> unvisited(n);
+    vector<int> slot(n);
+    for (int i = 0; i < n; i++) {
+        unvisited[i] = i;
+        slot[i] = i;
+    }
+    auto visit = [&](int c) {
+        int last = unvisited.back();
+        unvisited[slot[c]] = last;
+        slot[last] = slot[c];
+        unvisited.pop_back();
+        slot[c] = -1;
+        order.push_back(c);
+    };
+
+    int current = start;
+    visit(current);
+    while (!unvisited.empty()) {
+        int next = -1;
+        const int *cand = neighbours.of(current);
+        for (int r = 0; r < neighbours.getK() && next < 0; r++) {
+            if (slot[cand[r]] >= 0)
+                next = cand[r];
+        }
+        if (next < 0) {
+            double best = 0;
+            for (int c : unvisited) {
+                double d = dist(current, c);
+                if (next < 0 || d < best) {
+                    next = c;
+                    best = d;
+                }
+            }
+        }
+        visit(next);
+        current = next;
+    }
+    return order;
+}
+
+
+// Union-find root of >c<, with path halving.
+static int findRoot(vector<int> &parent, int c) {
+    while (parent[c] != c) {
+        parent[c] = parent[parent[c]];
+        c = parent[c];
+    }
+    return c;
+}
+
+/*
+ * Builds a tour with the greedy edge heuristic: candidate edges are taken
+ * shortest first and kept whenever neither end already has two edges and
+ * no cycle is closed. Only the neighbour-list edges are considered, so this
+ * leaves a set of paths, which are then joined nearest end first.
+ *
+ * Each edge length is scaled by a random factor in [1, 1 + noise), so a
+ * noise of 0 gives the plain greedy tour.
+ */
+vector<int> greedyEdgeTour(const DistanceMatrix &dist,
+                           const NeighbourLists &neighbours, double noise,
+                           Random &rng) {
+    int n = dist.size();
+    if (n < 3) {
+        vector<int> order(n);
+        for (int i = 0; i < n; i++)
+            order[i] = i;
+        return order;
+    }
+
+    struct Edge {
+        double length;
+        int a, b;
+        bool operator<(const Edge &e) const { return length < e.length; }
+    };
+    vector<Edge> edges;
+    edges.reserve((size_t) n * neighbours.getK());
+    for (int a = 0; a < n; a++) {
+        const int *cand = neighbours.of(a);
+        for (int r = 0; r < neighbours.getK(); r++) {
+            int b = cand[r];
+            if (a < b) {
+                double scale = 1 + noise * rng.uniform();
+                edges.push_back({ dist(a, b) * scale, a, b });
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    // adj[2c], adj[2c + 1] are the (up to two) tour neighbours of c.
+    vector<int> adj(2 * n, -1);
+    vector<int> degree(n, 0);
+    vector<int> parent(n);
+    for (int i = 0; i < n; i++)
+        parent[i] = i;
+    auto link = [&](int a, int b) {
+        adj[2 * a + degree[a]++] = b;
+        adj[2 * b + degree[b]++] = a;
+        parent[findRoot(parent, a)] = findRoot(parent, b);
+    };
+
+    int added = 0;
+    for (const Edge &e : edges) {
+        if (degree[e.a] < 2 && degree[e.b] < 2 &&
+            findRoot(parent, e.a) != findRoot(parent, e.b)) {
+            link(e.a, e.b);
+            if (++added == n - 1)
+                break;
+        }
+    }
+
+    // Join the paths: from the free end of the current path, link to the
+    // nearest free end of a path not yet joined.
+    vector<int> ends;
+    for (int c = 0; c < n; c++) {
+        if (degree[c] < 2)
+            ends.push_back(c);
+    }
+    // Far end of the path that has >c< as one end.
+    auto otherEnd = [&](int c) {
+        if (degree[c] == 0)
+            return c;
+        int prev = c;
+        int cur = adj[2 * c];
+        while (degree[cur] == 2) {
+            int next = adj[2 * cur] != prev ? adj[2 * cur] : adj[2 * cur + 1];
+            prev = cur;
+            cur = next;
+        }
+        return cur;
+    };
+
+    int current = otherEnd(ends[0]);
+    while (added < n - 1) {
+        int best = -1;
+        double bestDist = 0;
+        int root = findRoot(parent, current);
+        for (int c : ends) {
+            if (degree[c] < 2 && findRoot(parent, c) != root) {
+                double d = dist(current, c);
+                if (best < 0 || d < bestDist) {
+                    best = c;
+                    bestDist = d;
+                }
+            }
+        }
+        int far = otherEnd(best);
+        link(current, best);
+        added++;
+        current = far;
+    }
+
+    // Walk the single remaining path to get the order.
+    vector<int> order;
+    order.reserve(n);
+    int prev = -1;
+    int c = ends[0];
+    for (int i = 0; i < n; i++) {
+        order.push_back(c);
+        int next = adj[2 * c] != prev ? adj[2 * c] : adj[2 * c + 1];
+        prev = c;
+        c = next;
+    }
+    return order;
+}
+
+
+/*
+ * Maps a point on a 2^bits grid in >dims< dimensions to its position along
+ * a Hilbert curve, using Skilling's transpose algorithm.
+ */
+static uint64_t hilbertIndex(uint32_t x[3], int dims, int bits) {
+    uint32_t top = 1u << (bits - 1);
+
+    // Inverse undo excess work.
+    for (uint32_t q = top; q > 1; q >>= 1) {
+        uint32_t p = q - 1;
+        for (int i = 0; i < dims; i++) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            }
+            else {
+                uint32_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode.
+    for (int i = 1; i < dims; i++)
+        x[i] ^= x[i - 1];
+    uint32_t t = 0;
+    for (uint32_t q = top; q > 1; q >>= 1) {
+        if (x[dims - 1] & q)
+            t ^= q - 1;
+    }
+    for (int i = 0; i < dims; i++)
+        x[i] ^= t;
+
+    // Interleave the transposed bits into one index.
+    uint64_t index = 0;
+    for (int b = bits - 1; b >= 0; b--) {
+        for (int i = 0; i < dims; i++)
+            index = (index << 1) | ((x[i] >> b) & 1);
+    }
+    return index;
+}
+
+/*
+ * Orders the cities along a Hilbert curve through their bounding box.
+ * Cities close on the curve are close in space, so this is a fair tour
+ * in O(n log n). Dimensions in which all cities agree are left out, since
+ * a 3-D curve restricted to a plane has poor locality.
+ *
+ * The curve is laid over a cube twice the size of the box, with the box
+ * offset by >shift< (a fraction in [0, 1) of its side) in every dimension.
+ * Different shifts place the curve's turns differently relative to the
+ * cities, and so give different tours.
+ */
+vector<int> spaceFillingCurveTour(const vector<Point> &points, double shift) {
+    int n = points.size();
+    vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    if (n < 3)
+        return order;
+
+    double lo[3], hi[3];
+    for (int d = 0; d < 3; d++) {
+        lo[d] = 1e300;
+        hi[d] = -1e300;
+    }
+    for (const Point &p : points) {
+        double c[3] = { p.getX(), p.getY(), p.getZ() };
+        for (int d = 0; d < 3; d++) {
+            lo[d] = std::min(lo[d], c[d]);
+            hi[d] = std::max(hi[d], c[d]);
+        }
+    }
+
+    // One cube for all used dimensions, so distances are not distorted.
+    int used[3];
+    int dims = 0;
+    double side = 0;
+    for (int d = 0; d < 3; d++) {
+        if (hi[d] > lo[d]) {
+            used[dims++] = d;
+            side = std::max(side, hi[d] - lo[d]);
+        }
+    }
+    if (dims == 0)
+        return order;
+
+    int bits = std::min(31, 63 / dims);
+    const double cells = (double) (1u << (bits - 1)) * 2;
+    const uint32_t maxCell = (uint32_t) (cells - 1);
+    vector<uint64_t> key(n);
+    for (int i = 0; i < n; i++) {
+        double c[3] = { points[i].getX(), points[i].getY(), points[i].getZ() };
+        uint32_t grid[3];
+        for (int u = 0; u < dims; u++) {
+            int d = used[u];
+            double f = ((c[d] - lo[d]) / side + shift) / 2;
+            grid[u] = std::min((uint32_t) (f * cells), maxCell);
+        }
+        key[i] = hilbertIndex(grid, dims, bits);
+    }
+
+    std::sort(order.begin(), order.end(),
+              [&key](int a, int b) { return key[a] < key[b]; });
+    return order;
+}
+
+
+// Builds one randomized tour with the given heuristic. Cities known only
+// by their distances (>points< empty) have no curve to follow, so they get
+// a nearest-neighbour tour instead of a space-filling curve one.
+vector<int> constructTour(Construction method, const vector<Point> &points,
+                          const DistanceMatrix &dist,
+                          const NeighbourLists &neighbours, Random &rng) {
+    int n = dist.size();
+    if (n == 0)
+        return vector<int>();
+    if (method == Construction::SPACE_FILLING_CURVE && points.empty())
+        method = Construction::NEAREST_NEIGHBOUR;
+
+    switch (method) {
+    case Construction::NEAREST_NEIGHBOUR:
+        return nearestNeighbourTour(dist, neighbours, rng.below(n));
+    case Construction::GREEDY_EDGE:
+        return greedyEdgeTour(dist, neighbours, 0.1, rng);
+    default:
+        return spaceFillingCurveTour(points, rng.uniform());
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef CONSTRUCT_HH
+#define CONSTRUCT_HH
+
+#include "Random.hh"
+#include "local-search.hh"
+#include <vector>
+using namespace std;
+
+
+// Tour construction heuristics, used to seed the GA population with tours
+// that are far better than random ones. Each takes a source of randomness
+// so repeated calls give different tours.
+enum class Construction {
+    NEAREST_NEIGHBOUR,
+    GREEDY_EDGE,
+    SPACE_FILLING_CURVE
+};
+
+vector<int> nearestNeighbourTour(const DistanceMatrix &dist,
+                                 const NeighbourLists &neighbours, int start);
+vector<int> greedyEdgeTour(const DistanceMatrix &dist,
+                           const NeighbourLists &neighbours, double noise,
+                           Random &rng);
+vector<int> spaceFillingCurveTour(const vector<Point> &points,
+                                  double shift);
+vector<int> constructTour(Construction method, const vector<Point> &points,
+                          const DistanceMatrix &dist,
+                          const NeighbourLists &neighbours, Random &rng);
+
+
+#endif // CONSTRUCT_HH
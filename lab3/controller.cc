@@ -0,0 +1,96 @@
+#include "controller.hh"
+using namespace std;
+
+
+RunController::RunController(int numIslands, double timeLimit,
+                             double targetLength, int stallGenerations)
+    : timeLimit(timeLimit), targetLength(targetLength),
+      stallGenerations(stallGenerations),
+      start(chrono::steady_clock::now()), stopping(false),
+      stalled(numIslands, false), numStalled(0),
+      reason(StopReason::FINISHED), stopGeneration(-1) {
+}
+
+
+StopReason RunController::getReason() {
+    lock_guard<mutex> guard(this->lock);
+    return this->reason;
+}
+
+
+// The generation the run was stopped at, or -1 if it ran to the end.
+int RunController::getStopGeneration() {
+    lock_guard<mutex> guard(this->lock);
+    return this->stopGeneration;
+}
+
+
+double RunController::elapsedSeconds() const {
+    chrono::duration<double> elapsed =
+        chrono::steady_clock::now() - this->start;
+    return elapsed.count();
+}
+
+
+// Records the first reason to stop. Later ones are ignored.
+void RunController::stop(StopReason why, int generation) {
+    if (this->reason == StopReason::FINISHED) {
+        this->reason = why;
+        this->stopGeneration = generation;
+    }
+    this->stopping.store(true, memory_order_release);
+}
+
+
+/*
+ * Reports that >island< has evaluated >generation<, whose best tour is
+ * >bestLength< long, and that its best has not improved for the last
+ * >generationsWithoutImprovement< generations. Returns true if the run
+ * should stop, in which case the island should not breed another
+ * generation.
+ */
+bool RunController::update(int island, int generation, double bestLength,
+                           int generationsWithoutImprovement) {
+    if (this->isStopping())
+        return true;
+
+    bool overTime = this->timeLimit > 0 &&
+                    this->elapsedSeconds() >= this->timeLimit;
+    bool onTarget = this->targetLength > 0 &&
+                    bestLength <= this->targetLength;
+    if (!overTime && !onTarget && this->stallGenerations <= 0)
+        return false;
+
+    lock_guard<mutex> guard(this->lock);
+    if (overTime)
+        this->stop(StopReason::TIME_LIMIT, generation);
+    else if (onTarget)
+        this->stop(StopReason::TARGET, generation);
+    else {
+        // An island stops counting as stalled as soon as it improves,
+        // for instance through a migrant.
+        bool isStalled =
+            generationsWithoutImprovement >= this->stallGenerations;
+        if (isStalled != this->stalled[island]) {
+            this->stalled[island] = isStalled;
+            this->numStalled += isStalled ? 1 : -1;
+        }
+        if (this->numStalled == (int) this->stalled.size())
+            this->stop(StopReason::STALLED, generation);
+    }
+    return this->isStopping();
+}
+
+
+const char *stopReasonName(StopReason reason) {
+    switch (reason) {
+    case StopReason::TIME_LIMIT:
+        return "time limit reached";
+    case StopReason::TARGET:
+        return "target length reached";
+    case StopReason::STALLED:
+        return "no improvement";
+    default:
+        return "all generations run";
+    }
+}
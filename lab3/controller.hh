@@ -0,0 +1,73 @@
+#ifndef CONTROLLER_HH
+#define CONTROLLER_HH
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+
+// Why a GA run ended.
+enum class StopReason {
+    FINISHED,       // ran every generation it was asked to
+    TIME_LIMIT,     // out of wall-clock time
+    TARGET,         // found a tour at least as short as the target
+    STALLED         // no island improved for stallGenerations generations
+};
+
+
+// Decides when a GA run stops before its last generation. Every island
+// reports its best length once per generation; the first report that meets
+// a stopping criterion stops the whole run, and the islands check
+// isStopping() wherever they would otherwise wait for one another.
+//
+// A run stops once timeLimit seconds have passed since the controller was
+// made, once any island's best is at most targetLength, or once every
+// island has gone stallGenerations generations without improving its own
+// best. A zero turns the criterion off. The target and stall criteria only
+// depend on the islands' own progress, so a single-island run stops at the
+// same generation every time; with several islands, which generation each
+// one reaches depends on the threads' timing.
+class RunController {
+
+private:
+    double timeLimit;
+    double targetLength;
+    int stallGenerations;
+    chrono::steady_clock::time_point start;
+    atomic<bool> stopping;
+    mutex lock;                 // guards everything below
+    vector<bool> stalled;
+    int numStalled;
+    StopReason reason;
+    int stopGeneration;
+
+    void stop(StopReason why, int generation);
+
+public:
+    // Constructors
+    RunController(int numIslands, double timeLimit, double targetLength,
+                  int stallGenerations);
+
+    RunController(const RunController &) = delete;
+    RunController &operator=(const RunController &) = delete;
+
+    // Accessor methods
+    bool isStopping() const {
+        return this->stopping.load(memory_order_acquire);
+    }
+
+    StopReason getReason();
+    int getStopGeneration();
+    double elapsedSeconds() const;
+
+    // Other methods
+    bool update(int island, int generation, double bestLength,
+                int generationsWithoutImprovement);
+};
+
+const char *stopReasonName(StopReason reason);
+
+
+#endif // CONTROLLER_HH
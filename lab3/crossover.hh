@@ -0,0 +1,211 @@
+#ifndef CROSSOVER_HH
+#define CROSSOVER_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+using namespace std;
+
+
+// Crossover operators the GA can breed with.
+enum class Crossover {
+    CROSSLINK,          // prefix of one parent, rest in the other's order
+    ORDER,              // OX: segment of one parent, rest in the other's order
+    PARTIALLY_MAPPED,   // PMX: segment of one parent, rest mapped positionally
+    CYCLE               // CX: alternate whole position cycles of the parents
+};
+
+
+// A set of marked cities that is cleared in O(1): a city is marked when its
+// stamp equals the current one, so starting a new set is just bumping the
+// stamp. The stamps are only reset when the counter wraps around.
+class CityMarker {
+
+private:
+    vector<uint32_t> stamps;
+    uint32_t current;
+
+public:
+    // Constructors
+    CityMarker(int numCities) : stamps(numCities, 0), current(0) {}
+
+    // Starts a new, empty set.
+    void clear() {
+        if (++this->current == 0) {
+            std::fill(this->stamps.begin(), this->stamps.end(), 0);
+            this->current = 1;
+        }
+    }
+
+    void mark(int city) {
+        this->stamps[city] = this->current;
+    }
+
+    bool isMarked(int city) const {
+        return this->stamps[city] == this->current;
+    }
+};
+
+
+// Scratch space for the crossover operators, allocated once per breeding
+// thread so that breeding itself allocates nothing.
+struct CrossoverScratch {
+    CityMarker marker;
+    vector<int> position;       // position of each city in one parent
+
+    CrossoverScratch(int numCities)
+        : marker(numCities), position(numCities) {}
+};
+
+
+// The operators draw their random numbers from >rng<, anything with a
+// below(n) method like Random's, so that each population can breed from
+// its own stream.
+
+// Picks a random segment [lo, hi] of a tour of n cities.
+template <typename Rng>
+void randomSegment(int n, int &lo, int &hi, Rng &rng) {
+    lo = rng.below(n);
+    hi = rng.below(n);
+    if (lo > hi)
+        std::swap(lo, hi);
+}
+
+/*
+ * Crosslink: a random-length prefix of >p1<, then the remaining cities in
+ * the order they appear in >p2<.
+ */
+template <typename Index, typename Rng>
+void crosslinkCrossover(const Index *p1, const Index *p2, Index *child,
+                        int n, CrossoverScratch &scratch, Rng &rng) {
+    int offspringEnd = rng.below(n);
+    scratch.marker.clear();
+    for (int i = 0; i < offspringEnd; i++) {
+        child[i] = p1[i];
+        scratch.marker.mark(p1[i]);
+    }
+
+    int pos = offspringEnd;
+    for (int i = 0; i < n; i++) {
+        if (!scratch.marker.isMarked(p2[i]))
+            child[pos++] = p2[i];
+    }
+    assert(pos == n);
+}
+
+/*
+ * Order crossover (OX): the child keeps a random segment of >p1< in place
+ * and fills the other positions, starting after the segment and wrapping
+ * around, with the missing cities in the order they follow the segment in
+ * >p2<.
+ */
+template <typename Index, typename Rng>
+void orderCrossover(const Index *p1, const Index *p2, Index *child, int n,
+                    CrossoverScratch &scratch, Rng &rng) {
+    int lo, hi;
+    randomSegment(n, lo, hi, rng);
+
+    scratch.marker.clear();
+    for (int i = lo; i <= hi; i++) {
+        child[i] = p1[i];
+        scratch.marker.mark(p1[i]);
+    }
+
+    int pos = (hi + 1) % n;
+    for (int k = 0; k < n; k++) {
+        Index city = p2[(hi + 1 + k) % n];
+        if (!scratch.marker.isMarked(city)) {
+            child[pos] = city;
+            pos = (pos + 1) % n;
+        }
+    }
+    assert(pos == lo);
+}
+
+/*
+ * Partially-mapped crossover (PMX): the child keeps a random segment of
+ * >p1< in place and takes every other position from >p2<. A city of p2
+ * that is already in the segment is replaced by following the mapping
+ * p1[i] -> p2[i] of the segment until a city outside it is reached.
+ */
+template <typename Index, typename Rng>
+void partiallyMappedCrossover(const Index *p1, const Index *p2, Index *child,
+                              int n, CrossoverScratch &scratch, Rng &rng) {
+    int lo, hi;
+    randomSegment(n, lo, hi, rng);
+
+    scratch.marker.clear();
+    for (int i = lo; i <= hi; i++) {
+        child[i] = p1[i];
+        scratch.marker.mark(p1[i]);
+        scratch.position[p1[i]] = i;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (i == lo) {
+            i = hi;
+            continue;
+        }
+        Index city = p2[i];
+        while (scratch.marker.isMarked(city))
+            city = p2[scratch.position[city]];
+        child[i] = city;
+    }
+}
+
+/*
+ * Cycle crossover (CX): positions are split into cycles (follow position i
+ * to the position of p2[i] in p1 until getting back to i), and the child
+ * takes whole cycles alternately from >p1< and >p2<, so every city keeps
+ * the position it had in one of its parents. The first cycle starts at a
+ * random position.
+ */
+template <typename Index, typename Rng>
+void cycleCrossover(const Index *p1, const Index *p2, Index *child, int n,
+                    CrossoverScratch &scratch, Rng &rng) {
+    for (int i = 0; i < n; i++)
+        scratch.position[p1[i]] = i;
+
+    // Positions already assigned are marked (positions, not cities).
+    scratch.marker.clear();
+    int start = rng.below(n);
+    bool fromFirst = true;
+    for (int s = 0; s < n; s++) {
+        int begin = (start + s) % n;
+        if (scratch.marker.isMarked(begin))
+            continue;
+
+        int i = begin;
+        do {
+            scratch.marker.mark(i);
+            child[i] = fromFirst ? p1[i] : p2[i];
+            i = scratch.position[p2[i]];
+        } while (i != begin);
+        fromFirst = !fromFirst;
+    }
+}
+
+// Breeds >child< from >p1< and >p2< with the chosen operator.
+template <typename Index, typename Rng>
+void crossover(Crossover method, const Index *p1, const Index *p2,
+               Index *child, int n, CrossoverScratch &scratch, Rng &rng) {
+    switch (method) {
+    case Crossover::ORDER:
+        orderCrossover(p1, p2, child, n, scratch, rng);
+        break;
+    case Crossover::PARTIALLY_MAPPED:
+        partiallyMappedCrossover(p1, p2, child, n, scratch, rng);
+        break;
+    case Crossover::CYCLE:
+        cycleCrossover(p1, p2, child, n, scratch, rng);
+        break;
+    default:
+        crosslinkCrossover(p1, p2, child, n, scratch, rng);
+        break;
+    }
+}
+
+
+#endif // CROSSOVER_HH
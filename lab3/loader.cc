@@ -0,0 +1,306 @@
+#include "loader.hh"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+
+/* ========== Memory mapping ========== */
+
+// Maps a whole file read-only. Returns null (and sets >size< to 0) if the
+// file cannot be opened or is empty.
+static void *mapFile(const string &file, size_t &size) {
+    size = 0;
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info;
+    void *base = nullptr;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        base = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            base = nullptr;
+        }
+        else {
+            size = info.st_size;
+            madvise(base, size, MADV_SEQUENTIAL);
+        }
+    }
+    ::close(fd);
+    return base;
+}
+
+
+/* ========== Text format ========== */
+
+// Skips whitespace; returns false at the end of the buffer.
+static bool skipSpace(const char *&p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    return p < end;
+}
+
+/*
+ * Parses one decimal number at >p< and advances past it.
+ *
+ * Numbers with at most 15 significant digits and a small decimal exponent
+ * (which covers the lab2/tests files) are converted exactly with a single
+ * multiplication or division. Anything else is copied into a small buffer
+ * and handed to strtod, so the result always matches what cin would read.
+ * The mapped buffer is not NUL-terminated, which is why strtod is never
+ * called on it directly.
+ */
+static bool parseNumber(const char *&p, const char *end, double &value) {
+    static const double POW10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    if (!skipSpace(p, end))
+        return false;
+
+    const char *start = p;
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        anyDigits = true;
+        if (mantissa == 0 && *p == '0')
+            continue;
+        mantissa = mantissa * 10 + (*p - '0');
+        digits++;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            anyDigits = true;
+            exponent--;
+            if (mantissa == 0 && *p == '0')
+                continue;
+            mantissa = mantissa * 10 + (*p - '0');
+            digits++;
+        }
+    }
+    if (!anyDigits)
+        return false;
+
+    bool slowPath = digits > 15;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        slowPath = true;
+        p++;
+        if (p < end && (*p == '-' || *p == '+'))
+            p++;
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+    }
+    if (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+        return false;
+
+    if (!slowPath && exponent >= -22) {
+        value = (double) mantissa;
+        if (exponent < 0)
+            value /= POW10[-exponent];
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    char buffer[64];
+    size_t length = p - start;
+    if (length >= sizeof(buffer))
+        return false;
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    value = strtod(buffer, nullptr);
+    return true;
+}
+
+/*
+ * Loads points in the lab2/tests text format (a count, then x y z for each
+ * point) by mapping the file and parsing it in place.
+ */
+bool loadTextPoints(const string &file, vector<Point> &points) {
+    size_t size;
+    void *base = mapFile(file, size);
+    if (base == nullptr)
+        return false;
+
+    const char *p = static_cast<const char *>(base);
+    const char *end = p + size;
+
+    bool ok = false;
+    double count;
+    if (parseNumber(p, end, count) && count >= 0 && count == floor(count)) {
+        size_t numPoints = (size_t) count;
+        points.resize(numPoints);
+        ok = true;
+        double x, y, z;
+        for (size_t i = 0; i < numPoints && ok; i++) {
+            ok = parseNumber(p, end, x) && parseNumber(p, end, y) &&
+                 parseNumber(p, end, z);
+            points[i] = Point(x, y, z);
+        }
+    }
+
+    munmap(base, size);
+    return ok;
+}
+
+
+/* ========== Binary format ========== */
+
+MappedPoints::MappedPoints() : base(nullptr), mappedBytes(0), header(nullptr) {
+}
+
+
+MappedPoints::~MappedPoints() {
+    this->close();
+}
+
+
+// Maps >file< and checks its header and size.
+bool MappedPoints::open(const string &file) {
+    this->close();
+
+    this->base = mapFile(file, this->mappedBytes);
+    if (this->base == nullptr)
+        return false;
+
+    // The header is untrusted, so the payload is checked by division: a
+    // product of its fields could overflow and match a short file.
+    const BinaryPointsHeader *h =
+        static_cast<const BinaryPointsHeader *>(this->base);
+    bool ok = this->mappedBytes >= sizeof(BinaryPointsHeader) &&
+              memcmp(h->magic, "PTS1", 4) == 0 &&
+              h->dimension >= 1 && h->dimension <= 3;
+    if (ok) {
+        size_t payload = this->mappedBytes - sizeof(BinaryPointsHeader);
+        size_t pointBytes = h->dimension * sizeof(double);
+        ok = payload % pointBytes == 0 && h->count == payload / pointBytes;
+    }
+    if (!ok) {
+        this->close();
+        return false;
+    }
+
+    this->header = h;
+    return true;
+}
+
+
+// Unmaps the current file, if any.
+void MappedPoints::close() {
+    if (this->base != nullptr)
+        munmap(this->base, this->mappedBytes);
+    this->base = nullptr;
+    this->mappedBytes = 0;
+    this->header = nullptr;
+}
+
+
+// Gets the number of points in the file.
+size_t MappedPoints::size() const {
+    return this->header ? this->header->count : 0;
+}
+
+
+// Gets the number of coordinates stored per point.
+unsigned int MappedPoints::dimension() const {
+    return this->header ? this->header->dimension : 0;
+}
+
+
+// Gets the array of coordinate >dim< (0 = x, 1 = y, 2 = z) of every point,
+// straight out of the mapping. Returns null for dimensions not stored.
+const double *MappedPoints::coords(unsigned int dim) const {
+    if (this->header == nullptr || dim >= this->header->dimension)
+        return nullptr;
+    const double *first = reinterpret_cast<const double *>(this->header + 1);
+    return first + dim * this->header->count;
+}
+
+
+// Gets point i; coordinates that are not stored are 0.
+Point MappedPoints::point(size_t i) const {
+    const double *x = this->coords(0);
+    const double *y = this->coords(1);
+    const double *z = this->coords(2);
+    return Point(x ? x[i] : 0, y ? y[i] : 0, z ? z[i] : 0);
+}
+
+
+// Copies every point into >points<.
+void MappedPoints::toVector(vector<Point> &points) const {
+    size_t n = this->size();
+    points.resize(n);
+    for (size_t i = 0; i < n; i++)
+        points[i] = this->point(i);
+}
+
+
+// Loads a binary point file into a vector of points.
+bool loadBinaryPoints(const string &file, vector<Point> &points) {
+    MappedPoints mapped;
+    if (!mapped.open(file))
+        return false;
+    mapped.toVector(points);
+    return true;
+}
+
+
+// Loads either format, telling them apart by the binary magic number.
+bool loadPoints(const string &file, vector<Point> &points) {
+    FILE *f = fopen(file.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    char magic[4] = { 0 };
+    size_t got = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+
+    if (got == sizeof(magic) && memcmp(magic, "PTS1", 4) == 0)
+        return loadBinaryPoints(file, points);
+    return loadTextPoints(file, points);
+}
+
+
+// Writes >points< in the binary format with all three coordinates. The
+// file is written with one sequential write per coordinate array.
+bool writeBinaryPoints(const string &file, const vector<Point> &points) {
+    FILE *f = fopen(file.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+
+    BinaryPointsHeader header;
+    memcpy(header.magic, "PTS1", 4);
+    header.dimension = 3;
+    header.count = points.size();
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    vector<double> column(points.size());
+    for (unsigned int dim = 0; dim < 3 && ok; dim++) {
+        for (size_t i = 0; i < points.size(); i++) {
+            if (dim == 0)
+                column[i] = points[i].getX();
+            else if (dim == 1)
+                column[i] = points[i].getY();
+            else
+                column[i] = points[i].getZ();
+        }
+        ok = fwrite(column.data(), sizeof(double), column.size(), f) ==
+             column.size();
+    }
+
+    return fclose(f) == 0 && ok;
+}
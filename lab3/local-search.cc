@@ -0,0 +1,287 @@
+#include "local-search.hh"
+#include "ArrayTour.hh"
+#include "KDTree.hh"
+#include "TwoLevelTour.hh"
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+// Moves must gain more than this to be applied, so rounding noise cannot
+// make the search cycle.
+static const double EPSILON = 1e-10;
+
+
+/* ========== NeighbourLists ========== */
+
+// Finds the >k< nearest neighbours of every point with a k-d tree, on
+// >numThreads< threads (0 = all).
+NeighbourLists::NeighbourLists(const vector<Point> &points, int k,
+                               unsigned int numThreads) {
+    this->numCities = points.size();
+    this->k = std::max(0, std::min(k, this->numCities - 1));
+    KDTree tree(points);
+    this->neighbours = tree.allNearest(this->k, numThreads);
+}
+
+
+// Finds the >k< nearest neighbours of every city by scanning its row of
+// >dist<, for cities that have no coordinates to build a k-d tree on. This
+// takes O(n^2 log k), so it is meant for instances small enough to have a
+// full matrix. Ties go to the lower city.
+NeighbourLists::NeighbourLists(const DistanceMatrix &dist, int k) {
+    this->numCities = dist.size();
+    this->k = std::max(0, std::min(k, this->numCities - 1));
+    this->neighbours.resize((size_t) this->numCities * this->k);
+
+    vector<int> others;
+    for (int i = 0; i < this->numCities; i++) {
+        others.clear();
+        for (int j = 0; j < this->numCities; j++) {
+            if (j != i)
+                others.push_back(j);
+        }
+        std::partial_sort(others.begin(), others.begin() + this->k,
+                          others.end(), [&](int a, int b) {
+            double da = dist(i, a);
+            double db = dist(i, b);
+            return da < db || (da == db && a < b);
+        });
+        std::copy(others.begin(), others.begin() + this->k,
+                  this->neighbours.begin() + (size_t) i * this->k);
+    }
+}
+
+
+// Gets the number of cities.
+int NeighbourLists::size() const {
+    return this->numCities;
+}
+
+
+// Gets the number of neighbours stored per city.
+int NeighbourLists::getK() const {
+    return this->k;
+}
+
+
+// Gets the getK() nearest neighbours of >city<, nearest first.
+const int *NeighbourLists::of(int city) const {
+    return &this->neighbours[(size_t) city * this->k];
+}
+
+
+/* ========== Local search ========== */
+
+// State of one improveTour call, on a tour kept as a Tour (ArrayTour or
+// TwoLevelTour).
+template <typename Tour>
+class LocalSearch {
+
+private:
+    const DistanceMatrix &dist;
+    const NeighbourLists &neighbours;
+    const LocalSearchOptions &options;
+    Tour &tour;
+
+    // Cities whose don't-look bit is off, i.e. that are worth another look,
+    // in a ring buffer. A city is queued at most once, so n slots suffice.
+    vector<int> &active;
+    vector<bool> &queued;
+    int first;
+    int numActive;
+
+    double d(int a, int b) const {
+        return dist(a, b);
+    }
+
+    void wake(int c) {
+        if (!queued[c]) {
+            queued[c] = true;
+            int slot = first + numActive;
+            if (slot >= (int) active.size())
+                slot -= active.size();
+            active[slot] = c;
+            numActive++;
+        }
+    }
+
+    /*
+     * Tries to find an improving 2-opt move that removes an edge at >a<.
+     * For both tour neighbours b of a, candidate cities c are taken from
+     * a's neighbour list for as long as d(a, c) < d(a, b), since otherwise
+     * the move cannot gain anything. Returns the gain, or 0.
+     */
+    double tryTwoOpt(int a) {
+        const int *cand = neighbours.of(a);
+        for (int forward = 1; forward >= 0; forward--) {
+            int b = forward ? tour.next(a) : tour.prev(a);
+            double dab = d(a, b);
+            for (int r = 0; r < neighbours.getK(); r++) {
+                int c = cand[r];
+                double dac = d(a, c);
+                if (dac >= dab)
+                    break;
+                int e = forward ? tour.next(c) : tour.prev(c);
+                if (c == b || e == a)
+                    continue;
+
+                double delta = dac + d(b, e) - dab - d(c, e);
+                if (delta < -EPSILON) {
+                    tour.exchange(a, b, c, e);
+                    wake(a);
+                    wake(b);
+                    wake(c);
+                    wake(e);
+                    return -delta;
+                }
+            }
+        }
+        return 0;
+    }
+
+    /*
+     * Tries to find an improving Or-opt move for a segment of 1 to
+     * maxSegment cities starting at >a<: the segment is cut out and put back
+     * between two neighbouring cities elsewhere, possibly reversed. New
+     * positions are taken next to neighbours of the segment ends. Returns
+     * the gain, or 0.
+     */
+    double tryOrOpt(int a) {
+        int s1 = a;
+        int s2 = a;
+        int numCities = neighbours.size();
+        for (int len = 1; len <= options.maxSegment; len++) {
+            if (len > 1)
+                s2 = tour.next(s2);
+            if (len + 3 > numCities)
+                break;
+
+            int p = tour.prev(s1);
+            int n = tour.next(s2);
+            double removeGain = d(p, s1) + d(s2, n) - d(p, n);
+            if (removeGain <= EPSILON)
+                continue;
+
+            // Try both segment ends as the end that attaches to a neighbour.
+            for (int end = 0; end < 2; end++) {
+                int s = end == 0 ? s1 : s2;
+                const int *cand = neighbours.of(s);
+                for (int r = 0; r < neighbours.getK(); r++) {
+                    int c = cand[r];
+                    double dsc = d(s, c);
+                    if (dsc >= removeGain)
+                        break;
+                    if (tour.between(s1, c, s2))
+                        continue;
+
+                    // Attach s to c with c either before or after the
+                    // segment's new position.
+                    for (int side = 0; side < 2; side++) {
+                        int x = side == 0 ? c : tour.prev(c);
+                        int y = side == 0 ? tour.next(c) : c;
+                        if (x == p || y == p || tour.between(s1, x, s2))
+                            continue;
+
+                        // x s1..s2 y is "forward"; s has to touch c.
+                        bool reversed = (s == s1) != (x == c);
+                        double add = reversed
+                            ? d(x, s2) + d(s1, y) - d(x, y)
+                            : d(x, s1) + d(s2, y) - d(x, y);
+                        double delta = add - removeGain;
+                        if (delta < -EPSILON) {
+                            tour.moveSegment(s1, s2, x, y, reversed);
+                            wake(p);
+                            wake(n);
+                            wake(x);
+                            wake(y);
+                            wake(s1);
+                            wake(s2);
+                            return -delta;
+                        }
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+
+public:
+    LocalSearch(Tour &tour, const vector<int> &order,
+                const DistanceMatrix &dist, const NeighbourLists &neighbours,
+                const LocalSearchOptions &options,
+                LocalSearchScratch &scratch)
+        : dist(dist), neighbours(neighbours), options(options), tour(tour),
+          active(scratch.active), queued(scratch.queued), first(0),
+          numActive(0) {
+        active.resize(order.size());
+        queued.assign(order.size(), false);
+        for (int c : order)
+            wake(c);
+    }
+
+    // Runs until no city has an improving move. Returns the total gain.
+    double run() {
+        double total = 0;
+        while (numActive > 0) {
+            int a = active[first];
+            first = first + 1 == (int) active.size() ? 0 : first + 1;
+            numActive--;
+            queued[a] = false;
+
+            double gain = 0;
+            if (options.twoOpt)
+                gain = tryTwoOpt(a);
+            if (gain == 0 && options.orOpt)
+                gain = tryOrOpt(a);
+            total += gain;
+        }
+        return total;
+    }
+};
+
+
+/*
+ * Improves >order< in place with 2-opt and Or-opt moves until it is a local
+ * optimum for both, and returns how much shorter the tour became.
+ *
+ * Moves are only tried from cities whose don't-look bit is clear. All bits
+ * start clear; a city's bit is set when no move from it helps, and cleared
+ * again when one of its tour edges changes. With the candidate lists this
+ * makes each pass close to O(n) rather than O(n^2). Works on any tour of
+ * the cities in >dist<. Large tours are kept in a TwoLevelTour while they
+ * are improved, so a 2-opt move costs O(sqrt n) rather than O(n).
+ */
+double improveTour(vector<int> &order, const DistanceMatrix &dist,
+                   const NeighbourLists &neighbours,
+                   const LocalSearchOptions &options) {
+    LocalSearchScratch scratch;
+    return improveTour(order, dist, neighbours, options, scratch);
+}
+
+
+// Same as above, but keeps its working space in >scratch<, so repeated
+// calls allocate nothing.
+double improveTour(vector<int> &order, const DistanceMatrix &dist,
+                   const NeighbourLists &neighbours,
+                   const LocalSearchOptions &options,
+                   LocalSearchScratch &scratch) {
+    if (order.size() < 5)
+        return 0;
+    assert(neighbours.size() == (int) order.size());
+
+    // Above twoLevelCities cities, reversals on an array would dominate.
+    if ((int) order.size() >= options.twoLevelCities) {
+        TwoLevelTour &tour = scratch.twoLevel;
+        tour.assign(order);
+        LocalSearch<TwoLevelTour> search(tour, order, dist, neighbours,
+                                         options, scratch);
+        double gain = search.run();
+        tour.toOrder(order);
+        return gain;
+    }
+
+    ArrayTour tour(order, scratch.position);
+    LocalSearch<ArrayTour> search(tour, order, dist, neighbours, options,
+                                  scratch);
+    return search.run();
+}
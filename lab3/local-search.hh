@@ -0,0 +1,58 @@
+#ifndef LOCAL_SEARCH_HH
+#define LOCAL_SEARCH_HH
+
+#include "DistanceMatrix.hh"
+#include "TwoLevelTour.hh"
+#include <vector>
+using namespace std;
+
+
+// Candidate neighbours of every city: the k nearest other cities, nearest
+// first. Local search only tries moves that create an edge to one of these,
+// which is what keeps a pass close to linear in the number of cities.
+class NeighbourLists {
+
+private:
+    int numCities;
+    int k;
+    vector<int> neighbours;     // row i holds the neighbours of city i
+
+public:
+    // Constructors
+    NeighbourLists(const vector<Point> &points, int k,
+                   unsigned int numThreads);
+    NeighbourLists(const DistanceMatrix &dist, int k);
+
+    // Accessor methods
+    int size() const;
+    int getK() const;
+    const int *of(int city) const;
+};
+
+// Which moves improveTour tries.
+struct LocalSearchOptions {
+    bool twoOpt = true;
+    bool orOpt = true;
+    int maxSegment = 3;     // longest segment Or-opt moves
+    int twoLevelCities = 1000;  // from this many cities, use a TwoLevelTour
+};
+
+// Working space for improveTour. Calls that share one reuse its buffers,
+// so after the first call on a tour of a given size they allocate nothing.
+struct LocalSearchScratch {
+    vector<int> position;   // of each city, for tours kept as an ArrayTour
+    vector<int> active;     // ring buffer of the cities worth a look
+    vector<bool> queued;
+    TwoLevelTour twoLevel;  // for tours of twoLevelCities or more
+};
+
+double improveTour(vector<int> &order, const DistanceMatrix &dist,
+                   const NeighbourLists &neighbours,
+                   const LocalSearchOptions &options = LocalSearchOptions());
+double improveTour(vector<int> &order, const DistanceMatrix &dist,
+                   const NeighbourLists &neighbours,
+                   const LocalSearchOptions &options,
+                   LocalSearchScratch &scratch);
+
+
+#endif // LOCAL_SEARCH_HH
@@ -0,0 +1,69 @@
+#include "selection.hh"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+
+// Reorders >ranked< so that its first k entries are the k shortest genomes,
+// sorted shortest first; the rest are left in no particular order. This
+// costs O(n + k log k) instead of sorting the whole population.
+void rankFittest(vector<RankedGenome> &ranked, int k) {
+    auto shorter = [](const RankedGenome &a, const RankedGenome &b) {
+        return a.length < b.length;
+    };
+
+    k = std::min(k, (int) ranked.size());
+    if (k <= 0)
+        return;
+    std::nth_element(ranked.begin(), ranked.begin() + (k - 1), ranked.end(),
+                     shorter);
+    std::sort(ranked.begin(), ranked.begin() + k, shorter);
+}
+
+
+/*
+ * Picks a parent and returns its position in >ranked<, which rankFittest
+ * has ordered so the first >keep< entries are the fittest, shortest first.
+ * The position >exclude< is never returned, so two calls can pick two
+ * different parents; pass -1 to allow any.
+ *
+ * Truncation and rank selection only pick among the fittest >keep<. A
+ * tournament draws >tournamentSize< contestants from the whole population
+ * and returns the shortest. If excluding would leave nothing to pick from
+ * (one genome, or keep < 2), >exclude< is ignored, so a call always
+ * returns.
+ */
+int selectParent(Selection method, const vector<RankedGenome> &ranked,
+                 int keep, int tournamentSize, int exclude, Random &rng) {
+    int n = ranked.size();
+    keep = std::max(1, std::min(keep, n));
+    int candidates = method == Selection::TOURNAMENT ? n : keep;
+    if (candidates < 2)
+        exclude = -1;
+
+    int pick;
+    switch (method) {
+    case Selection::TOURNAMENT:
+        pick = -1;
+        for (int t = 0; t < tournamentSize || pick == -1; t++) {
+            int contestant = rng.below(n);
+            if (contestant == exclude)
+                continue;
+            if (pick == -1 || ranked[contestant].length < ranked[pick].length)
+                pick = contestant;
+        }
+        return pick;
+    case Selection::RANK:
+        // Position i is picked with probability proportional to keep - i,
+        // by inverting the cumulative distribution.
+        do {
+            pick = (int) (keep * (1 - sqrt(1 - rng.uniform())));
+        } while (pick == exclude || pick >= keep);
+        return pick;
+    default:
+        do {
+            pick = rng.below(keep);
+        } while (pick == exclude);
+        return pick;
+    }
+}
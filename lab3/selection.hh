@@ -0,0 +1,29 @@
+#ifndef SELECTION_HH
+#define SELECTION_HH
+
+#include "Random.hh"
+#include <vector>
+using namespace std;
+
+
+// How the GA picks the parents of each offspring.
+enum class Selection {
+    TRUNCATION,     // uniformly among the keepPopulation fittest
+    TOURNAMENT,     // fittest of a few genomes drawn from the whole population
+    RANK            // among the fittest, with odds falling linearly by rank
+};
+
+
+// A genome's circuit length and its slot in the population. Selection
+// works on a compact array of these instead of chasing into the genomes.
+struct RankedGenome {
+    double length;
+    int index;
+};
+
+void rankFittest(vector<RankedGenome> &ranked, int k);
+int selectParent(Selection method, const vector<RankedGenome> &ranked,
+                 int keep, int tournamentSize, int exclude, Random &rng);
+
+
+#endif // SELECTION_HH
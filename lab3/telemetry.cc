@@ -0,0 +1,92 @@
+#include "telemetry.hh"
+#include <iomanip>
+using namespace std;
+
+
+/* ========== FileTelemetry ========== */
+
+// Opens >path< for writing and starts the writer thread.
+FileTelemetry::FileTelemetry(const string &path, TelemetryFormat format)
+    : out(path), format(format), stopping(false) {
+    // Enough digits that a length read back equals the one written.
+    this->out << setprecision(17);
+    if (this->format == TelemetryFormat::CSV) {
+        this->out << "island,generation,best,mean,worst,diversity,"
+                  << "evaluate_s,select_s,breed_s,mutate_s,allocations\n";
+    }
+    this->writer = thread(&FileTelemetry::writerLoop, this);
+}
+
+
+FileTelemetry::~FileTelemetry() {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->hasRecords.notify_one();
+    this->writer.join();
+    this->out.flush();
+}
+
+
+// Returns true if the file could be opened.
+bool FileTelemetry::isOpen() const {
+    return this->out.is_open();
+}
+
+
+// Queues a record for the writer thread.
+void FileTelemetry::record(const GenerationRecord &r) {
+    {
+        unique_lock<mutex> guard(this->lock);
+        this->pending.push_back(r);
+    }
+    this->hasRecords.notify_one();
+}
+
+
+// Takes whatever has been queued, a batch at a time, and writes it out.
+// Swapping the queue out keeps the lock held only for the swap.
+void FileTelemetry::writerLoop() {
+    vector<GenerationRecord> batch;
+    while (true) {
+        {
+            unique_lock<mutex> guard(this->lock);
+            this->hasRecords.wait(guard, [this]() {
+                return this->stopping || !this->pending.empty();
+            });
+            if (this->pending.empty() && this->stopping)
+                return;
+            batch.swap(this->pending);
+        }
+
+        for (const GenerationRecord &r : batch)
+            this->write(r);
+        batch.clear();
+    }
+}
+
+
+void FileTelemetry::write(const GenerationRecord &r) {
+    if (this->format == TelemetryFormat::CSV) {
+        this->out << r.island << ',' << r.generation << ','
+                  << r.bestLength << ',' << r.meanLength << ','
+                  << r.worstLength << ',' << r.diversity << ','
+                  << r.evaluateSeconds << ',' << r.selectSeconds << ','
+                  << r.breedSeconds << ',' << r.mutateSeconds << ','
+                  << r.allocations << '\n';
+    }
+    else {
+        this->out << "{\"island\":" << r.island
+                  << ",\"generation\":" << r.generation
+                  << ",\"best\":" << r.bestLength
+                  << ",\"mean\":" << r.meanLength
+                  << ",\"worst\":" << r.worstLength
+                  << ",\"diversity\":" << r.diversity
+                  << ",\"evaluate_s\":" << r.evaluateSeconds
+                  << ",\"select_s\":" << r.selectSeconds
+                  << ",\"breed_s\":" << r.breedSeconds
+                  << ",\"mutate_s\":" << r.mutateSeconds
+                  << ",\"allocations\":" << r.allocations << "}\n";
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef TELEMETRY_HH
+#define TELEMETRY_HH
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+// What the GA reports about one generation of one island.
+struct GenerationRecord {
+    int island;
+    int generation;
+    double bestLength;
+    double meanLength;
+    double worstLength;
+    double diversity;       // share of edges not in the best tour, averaged
+    double evaluateSeconds; // computing circuit lengths
+    double selectSeconds;   // ranking and migration
+    double breedSeconds;    // crossover and local search
+    double mutateSeconds;
+    // Heap allocations made by the island's own thread during the
+    // generation, or 0 if the binary does not link alloc-count.o.
+    // Approximate: work the island hands to a thread pool is not counted.
+    uint64_t allocations;
+};
+
+// Receives a record per generation. record() is called from the GA's own
+// threads, in the middle of a run, so it must be cheap and thread-safe.
+class TelemetrySink {
+
+public:
+    virtual ~TelemetrySink() {}
+    virtual void record(const GenerationRecord &r) = 0;
+};
+
+
+enum class TelemetryFormat {
+    CSV,            // a header line, then one line per record
+    JSON_LINES      // one JSON object per line
+};
+
+// A sink that writes the records to a file. record() only queues the
+// record; a background thread formats the queued records and writes them
+// through a buffered stream, so the GA never waits on the disk.
+class FileTelemetry : public TelemetrySink {
+
+private:
+    ofstream out;
+    TelemetryFormat format;
+    vector<GenerationRecord> pending;
+    mutex lock;
+    condition_variable hasRecords;
+    bool stopping;
+    thread writer;
+
+    void writerLoop();
+    void write(const GenerationRecord &r);
+
+public:
+    // Constructors
+    FileTelemetry(const string &path, TelemetryFormat format);
+
+    // Destructor - writes out everything queued, then stops the writer.
+    ~FileTelemetry();
+
+    FileTelemetry(const FileTelemetry &) = delete;
+    FileTelemetry &operator=(const FileTelemetry &) = delete;
+
+    // Accessor methods
+    bool isOpen() const;
+
+    // Other methods
+    void record(const GenerationRecord &r) override;
+};
+
+
+#endif // TELEMETRY_HH
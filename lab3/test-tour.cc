@@ -0,0 +1,282 @@
+#include "testbase.hh"
+#include "ArrayTour.hh"
+#include "TwoLevelTour.hh"
+#include "Random.hh"
+
+#include <iostream>
+#include <vector>
+
+
+using namespace std;
+
+
+/*===========================================================================
+ * HELPER FUNCTIONS
+ *
+ * TwoLevelTour is checked against ArrayTour, doing the same random moves
+ * on both. A move can leave the two tours the same but running in opposite
+ * directions, so every comparison first finds out which way the two-level
+ * tour runs compared to the array tour, and reads it that way.
+ */
+
+
+// A random order of the cities 0, ..., n - 1.
+vector<int> randomTour(int n, Random &rng) {
+    vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    for (int i = n - 1; i > 0; i--)
+        swap(order[i], order[rng.below(i + 1)]);
+    return order;
+}
+
+
+// True if >two< runs the other way round from >array<.
+bool reversed(const ArrayTour &array, const TwoLevelTour &two) {
+    return two.next(0) != array.next(0);
+}
+
+
+// The city after >c< in >two<, read in the direction of >array<.
+int nextAlong(const TwoLevelTour &two, bool flip, int c) {
+    return flip ? two.prev(c) : two.next(c);
+}
+
+
+int prevAlong(const TwoLevelTour &two, bool flip, int c) {
+    return flip ? two.next(c) : two.prev(c);
+}
+
+
+/*
+ * True if >two< holds the same tour as >array<, in either direction:
+ * every city has the same neighbours on the same side, and >numQueries<
+ * random between() queries agree.
+ */
+bool sameTour(const ArrayTour &array, const TwoLevelTour &two, int n,
+              int numQueries, Random &rng) {
+    if (two.size() != n)
+        return false;
+    bool flip = reversed(array, two);
+    for (int c = 0; c < n; c++) {
+        if (array.next(c) != nextAlong(two, flip, c) ||
+            array.prev(c) != prevAlong(two, flip, c))
+            return false;
+    }
+    for (int i = 0; i < numQueries; i++) {
+        int a = rng.below(n);
+        int b = rng.below(n);
+        int c = rng.below(n);
+        bool between = flip ? two.between(c, b, a) : two.between(a, b, c);
+        if (array.between(a, b, c) != between)
+            return false;
+    }
+    return true;
+}
+
+
+// True if >order< visits each of the cities 0, ..., n - 1 once.
+bool isPermutation(const vector<int> &order, int n) {
+    if ((int) order.size() != n)
+        return false;
+    vector<bool> seen(n, false);
+    for (int c : order) {
+        if (c < 0 || c >= n || seen[c])
+            return false;
+        seen[c] = true;
+    }
+    return true;
+}
+
+
+/*
+ * Does a random 2-opt move on both tours: the edges after two random
+ * cities of >two< are exchanged. Returns false if the cities picked do not
+ * give a move.
+ */
+bool randomTwoOpt(ArrayTour &array, TwoLevelTour &two, int n, Random &rng) {
+    int a = rng.below(n);
+    int c = rng.below(n);
+    int b = two.next(a);
+    int d = two.next(c);
+    if (a == c || b == c || d == a)
+        return false;
+    two.exchange(a, b, c, d);
+    array.exchange(a, b, c, d);
+    return true;
+}
+
+
+/*
+ * Does a random Or-opt move on both tours: a path of 1 to 3 cities of
+ * >two< is moved between two other neighbours, kept as it is or reversed.
+ * Returns false if the cities picked do not give a move.
+ */
+bool randomOrOpt(ArrayTour &array, TwoLevelTour &two, int n, Random &rng) {
+    int len = 1 + rng.below(3);
+    if (len + 3 > n)
+        return false;
+    int s1 = rng.below(n);
+    int s2 = s1;
+    for (int i = 1; i < len; i++)
+        s2 = two.next(s2);
+    int x = rng.below(n);
+    int y = two.next(x);
+    if (two.between(s1, x, s2) || two.between(s1, y, s2))
+        return false;
+
+    // Neither x nor y may be the city just before the path, in the
+    // direction of either tour.
+    bool flip = reversed(array, two);
+    int p = two.prev(s1);
+    int q = two.next(s2);
+    if (x == p || y == p || (flip && (x == q || y == q)))
+        return false;
+
+    bool reverse = rng.below(2);
+    two.moveSegment(s1, s2, x, y, reverse);
+    if (flip)
+        array.moveSegment(s2, s1, y, x, reverse);
+    else
+        array.moveSegment(s1, s2, x, y, reverse);
+    return true;
+}
+
+
+/*
+ * Does >numMoves< random moves on tours of each size in >sizes<, and
+ * returns true if the tours agree after every move and still visit every
+ * city once at the end. >orOptShare< is the odds of a move being an Or-opt
+ * move rather than a 2-opt move. Every tour over 5 cities also has to end
+ * up running the other way round at some point, or half the comparison
+ * went untested.
+ */
+bool movesAgree(const vector<int> &sizes, int numMoves, double orOptShare,
+                uint64_t seed) {
+    Random rng(seed);
+    for (int n : sizes) {
+        vector<int> order = randomTour(n, rng);
+        vector<int> arrayOrder = order;
+        ArrayTour array(arrayOrder);
+        TwoLevelTour two(order);
+
+        bool flipped = false;
+        int done = 0;
+        for (int i = 0; i < numMoves; i++) {
+            bool moved = rng.uniform() < orOptShare ?
+                randomOrOpt(array, two, n, rng) :
+                randomTwoOpt(array, two, n, rng);
+            if (!moved)
+                continue;
+            done++;
+            flipped = flipped || reversed(array, two);
+            if (!sameTour(array, two, n, 5, rng))
+                return false;
+        }
+
+        vector<int> back;
+        two.toOrder(back);
+        if (done == 0 || (n > 5 && !flipped) || !isPermutation(back, n) ||
+            !isPermutation(arrayOrder, n))
+            return false;
+    }
+    return true;
+}
+
+
+/*===========================================================================
+ * TEST FUNCTIONS
+ *
+ * These are called by the main() function at the end of this file.
+ */
+
+
+/*! Test building a two-level tour and writing it back. */
+void test_build(TestContext &ctx) {
+    Random rng(1);
+
+    ctx.DESC("Two-level tour built from an order");
+
+    for (int n : {1, 2, 3, 4, 5, 10, 16, 17, 100, 1001}) {
+        vector<int> order = randomTour(n, rng);
+        vector<int> arrayOrder = order;
+        ArrayTour array(arrayOrder);
+        TwoLevelTour two(order);
+        if (n >= 3)
+            ctx.CHECK(sameTour(array, two, n, 100, rng));
+
+        vector<int> back;
+        two.toOrder(back);
+        ctx.CHECK(isPermutation(back, n));
+        if (n >= 3)
+            ctx.CHECK(sameTour(ArrayTour(back), two, n, 0, rng));
+    }
+
+    ctx.result();
+
+    ctx.DESC("Two-level tour reassigned to other orders");
+
+    TwoLevelTour two;
+    ctx.CHECK(two.size() == 0);
+    for (int n : {50, 7, 200, 50}) {
+        vector<int> order = randomTour(n, rng);
+        vector<int> arrayOrder = order;
+        two.assign(order);
+        ctx.CHECK(sameTour(ArrayTour(arrayOrder), two, n, 100, rng));
+    }
+
+    ctx.result();
+}
+
+
+/*! Test 2-opt moves against ArrayTour. */
+void test_two_opt(TestContext &ctx) {
+    ctx.DESC("2-opt moves on small tours");
+    ctx.CHECK(movesAgree({4, 5, 6, 7, 9, 10, 17}, 2000, 0, 2));
+    ctx.result();
+
+    ctx.DESC("2-opt moves on large tours");
+    ctx.CHECK(movesAgree({101, 400, 1000}, 5000, 0, 3));
+    ctx.result();
+}
+
+
+/*! Test Or-opt moves against ArrayTour. */
+void test_or_opt(TestContext &ctx) {
+    ctx.DESC("Or-opt moves on small tours");
+    ctx.CHECK(movesAgree({4, 5, 6, 7, 9, 10, 17}, 2000, 1, 4));
+    ctx.result();
+
+    ctx.DESC("Or-opt moves on large tours");
+    ctx.CHECK(movesAgree({101, 400, 1000}, 5000, 1, 5));
+    ctx.result();
+}
+
+
+/*! Test a long run of mixed moves, which unbalances and rebuilds. */
+void test_mixed(TestContext &ctx) {
+    ctx.DESC("Mixed moves on small tours");
+    ctx.CHECK(movesAgree({4, 5, 6, 7, 9, 10, 17, 50}, 20000, 0.5, 6));
+    ctx.result();
+
+    ctx.DESC("Mixed moves on large tours");
+    ctx.CHECK(movesAgree({101, 400, 1000, 3000}, 20000, 0.5, 7));
+    ctx.result();
+}
+
+
+/*! This program checks TwoLevelTour against ArrayTour. */
+int main() {
+
+    cout << "Testing two-level tours." << endl << endl;
+
+    TestContext ctx(cout);
+
+    test_build(ctx);
+    test_two_opt(ctx);
+    test_or_opt(ctx);
+    test_mixed(ctx);
+
+    // Return 0 if everything passed, nonzero if something failed.
+    return !ctx.ok();
+}
@@ -1,167 +1,724 @@
 #include "tsp-ga.hh"
+#include "Population.hh"
+#include "ThreadPool.hh"
+#include "alloc-count.hh"
+#include "checkpoint.hh"
+#include "controller.hh"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <cstdlib>
 #include <iostream>
-#include <set>
+#include <limits>
+#include <numeric>
+#include <thread>
 using namespace std;
 
-/* ========== Member Functions ========== */
+// Where one island leaves its best genomes for the next island on the
+// ring. Only its sender writes it and only its receiver reads it, and the
+// full flag hands it back and forth, so no lock is needed. The receiver of
+// a migration always gets the migrants sent in that same migration, which
+// keeps island runs reproducible: either side briefly waits (yielding its
+// thread) if the other is behind.
+template <typename Index>
+struct Mailbox {
+    vector<Index> orders;       // count x numCities
+    vector<double> lengths;
+    int count;
+    atomic<bool> full;
+
+    Mailbox() : count(0), full(false) {}
+};
+
+
+// With adaptive operators, every ADAPT_INTERVAL generations an island
+// steers its diversity towards [MIN_DIVERSITY, MAX_DIVERSITY]. Below the
+// band, it mutates populationSize / 20 (at least one) more genomes per
+// generation and breeds CROSSOVER_RATE_STEP fewer of its offspring by
+// crossover, down to MIN_CROSSOVER_RATE; above it, it steps back.
+const int ADAPT_INTERVAL = 10;
+const double MIN_DIVERSITY = 0.1;
+const double MAX_DIVERSITY = 0.3;
+const double CROSSOVER_RATE_STEP = 0.1;
+const double MIN_CROSSOVER_RATE = 0.5;
+
+// The part of an island's state that run control and adaptation keep,
+// saved with the island in snapshots.
+struct IslandProgress {
+    double bestSeen;            // shortest length the island has had
+    int32_t generationsWithoutImprovement;
+    int32_t mutationCount;      // numMutations, unless adapted
+    double crossoverRate;       // share of offspring bred by crossover
+};
+
+
+/*
+ * One population of the genetic algorithm behind findAShortPath.
+ *
+ * The population lives in a flat Population matrix. Each generation is
+ * evaluated, ranked, and then bred into the population's second buffer:
+ * the keepPopulation fittest genomes are copied over, the remaining slots
+ * are filled with offspring of pairs of parents picked by the chosen
+ * selection method (bred with the chosen crossover operator straight
+ * into their slots), and then random
+ * genomes other than the best are mutated. Apart from setup, nothing is
+ * allocated while the run goes on.
+ *
+ * Only offspring are evaluated in full. Carried-over genomes keep their
+ * lengths, and mutations adjust a genome's length by the edges they touch,
+ * so each generation measures populationSize - keepPopulation tours rather
+ * than all of them. Ranking only partially sorts a compact array of
+ * (length, slot) pairs, since only the elites need to be in order.
+ *
+ * An island draws all its random numbers from its own engine, so islands
+ * can evolve on different threads at once. If the options name a telemetry
+ * sink, each generation is timed phase by phase and reported to it. Each
+ * generation's best is reported to the run's controller, which may end the
+ * run there.
+ */
+template <typename Index>
+class Island {
+
+private:
+    const DistanceMatrix &dist;
+    const NeighbourLists *neighbours;
+    GAOptions options;
+    int id;                     // this island's number, for telemetry
+    int populationSize;
+    int keepPopulation;
+    int numMutations;
+    int numCities;
+    Random rng;
+    Population<Index> population;
+    ThreadPool *pool;           // spreads evaluation, or null
+    RunController *controller;
+    IslandProgress progress;
+
+    // Scratch space, allocated once for the whole run.
+    vector<RankedGenome> ranking;
+    CrossoverScratch scratch;
+    vector<int> tour;
+    LocalSearchScratch localSearch;
+    vector<int> successor;      // for diversity, only when measured
+
+    function<void(size_t, size_t)> evaluateRange;
+
+    // Computes the circuit length of each genome that changed.
+    void evaluate() {
+        if (this->pool)
+            this->pool->parallelFor(0, this->populationSize, 0,
+                                    this->evaluateRange);
+        else
+            this->evaluateRange(0, this->populationSize);
+    }
 
-// Constructor that initializes the order vector to be some random 
-// order of points and the circuitLength to be equal to dummyLength.
-TSPGenome::TSPGenome(int numPoints) {
-   this->order.resize(numPoints);
-   // Initialize to 0, 1, 2, ..., numPoints - 1
-   std::iota(this->order.begin(), this->order.end(), 0);
-   std::random_shuffle(this->order.begin(), this->order.end());
-   this->circuitLength = this->DUMMY_LENGTH;
-}
+    // Only the fittest keepPopulation (at least one, for getBest) come
+    // out sorted; the rest of the ranking is in no particular order.
+    void rank() {
+        for (int i = 0; i < this->populationSize; i++) {
+            this->ranking[i].length = this->population.getLength(i);
+            this->ranking[i].index = i;
+        }
+        rankFittest(this->ranking, std::max(this->keepPopulation, 1));
+    }
 
-// Constructor that initializes the order vector with the passed-in vector.
-TSPGenome::TSPGenome(const vector<int> &order) {
-    this->order = order;
-    this->circuitLength = this->DUMMY_LENGTH;
-}
+    // Returns the share of a genome's edges that the best tour does not
+    // have, averaged over the population: 0 once every genome is the best
+    // tour, and close to 1 for random tours.
+    double diversity() {
+        int n = this->numCities;
+        const Index *best = this->getBest();
+        for (int i = 0; i < n; i++)
+            this->successor[best[i]] = best[(i + 1) % n];
+
+        double total = 0;
+        for (int g = 0; g < this->populationSize; g++) {
+            const Index *order = this->population.getOrder(g);
+            int shared = 0;
+            for (int i = 0; i < n; i++) {
+                int a = order[i];
+                int b = order[(i + 1) % n];
+                if (this->successor[a] == b || this->successor[b] == a)
+                    shared++;
+            }
+            total += 1 - (double) shared / n;
+        }
+        return total / this->populationSize;
+    }
 
+    // Moves the mutation count and crossover rate one step towards more
+    // exploration if the population has converged, or one step back
+    // towards the configured operators if it is diverse.
+    void adapt(double diversity) {
+        int step = std::max(1, this->populationSize / 20);
+        int maxMutations = std::max(this->numMutations, this->populationSize);
+        if (diversity < MIN_DIVERSITY) {
+            this->progress.mutationCount =
+                std::min(this->progress.mutationCount + step, maxMutations);
+            this->progress.crossoverRate =
+                std::max(this->progress.crossoverRate - CROSSOVER_RATE_STEP,
+                         MIN_CROSSOVER_RATE);
+        }
+        else if (diversity > MAX_DIVERSITY) {
+            this->progress.mutationCount =
+                std::max(this->progress.mutationCount - step,
+                         this->numMutations);
+            this->progress.crossoverRate =
+                std::min(this->progress.crossoverRate + CROSSOVER_RATE_STEP,
+                         1.0);
+        }
+    }
 
-// Gets genome's current visit order.
-vector<int> TSPGenome::getOrder() const {
-    return this->order;
-}
+    static double secondsSince(chrono::steady_clock::time_point start) {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
 
+public:
+    // Constructors. Generates the initial population: the first
+    // seedFraction of it comes from the construction heuristics in turn,
+    // the rest is random.
+    Island(const vector<Point> &points, const DistanceMatrix &dist,
+           const NeighbourLists *neighbours, int populationSize,
+           int keepPopulation, int numMutations, const GAOptions &options,
+           int id, const Random &rng, ThreadPool *pool,
+           RunController *controller)
+        : dist(dist), neighbours(neighbours), options(options), id(id),
+          populationSize(populationSize), keepPopulation(keepPopulation),
+          numMutations(numMutations), numCities(dist.size()), rng(rng),
+          population(populationSize, dist.size()), pool(pool),
+          controller(controller), ranking(populationSize),
+          scratch(dist.size()), tour(dist.size()) {
+        this->progress.bestSeen = numeric_limits<double>::infinity();
+        this->progress.generationsWithoutImprovement = 0;
+        this->progress.mutationCount = numMutations;
+        this->progress.crossoverRate = 1;
+
+        int numSeeded = (int) (options.seedFraction * populationSize);
+        for (int i = 0; i < populationSize; ++i) {
+            Index *order = this->population.genome(i).order;
+            if (i < numSeeded) {
+                Construction method = (Construction) (i % 3);
+                vector<int> tour = constructTour(method, points, dist,
+                                                 *neighbours, this->rng);
+                std::copy(tour.begin(), tour.end(), order);
+            }
+            else {
+                randomOrder(order, this->numCities, this->rng);
+            }
+        }
 
-// Gets genome's current circuit length.
-double TSPGenome::getCircuitLength() const {
-    return this->circuitLength;
-}
+        if (options.telemetry || options.adaptive)
+            this->successor.resize(this->numCities);
+
+        // With a pool each genome is still evaluated by exactly one
+        // thread, in the same way, so the lengths are identical to a
+        // serial run.
+        this->evaluateRange = [this](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                GenomeView<Index> g = this->population.genome(i);
+                if (*g.valid)
+                    continue;
+                *g.length = orderLength(g.order, this->numCities,
+                                        this->dist);
+                *g.valid = 1;
+            }
+        };
+    }
 
+    Island(const Island &) = delete;
+    Island &operator=(const Island &) = delete;
 
-// Computes circuit length from traversing the passed-in points in the 
-// order specified by this object.
-void TSPGenome::computeCircuitLength(const vector<Point> &points) {
-    double length = 0;
-    for (unsigned int i = 0; i < this->order.size(); i++) {
-        int next;
-        if (i == this->order.size() - 1)
-            next = 0;
-        else
-            next = i + 1;
+    // Accessor methods
 
-        length += points[this->order[i]].distanceTo(points[this->order[next]]);
+    // The fittest genome as of the last evaluation.
+    const Index *getBest() const {
+        return this->population.getOrder(this->ranking[0].index);
     }
-    
-    // Update length.
-    this->circuitLength = length;
-}
 
+    double getBestLength() const {
+        return this->ranking[0].length;
+    }
 
-// "Mutates" the genome by swapping two randomly-selected values in the order 
-// vector.
-void TSPGenome::mutate() {
-    // If we have less than 2 elements, we can't mutate 
-    if (this->order.size() < 2)
-        return;
+    // Size in bytes of the island's state as save() writes it, rounded up
+    // so that consecutive blocks stay 8-byte aligned.
+    size_t snapshotBytes() const {
+        size_t bytes = sizeof(uint64_t) * 4 + sizeof(IslandProgress) +
+                       this->population.snapshotBytes();
+        return (bytes + 7) / 8 * 8;
+    }
 
-    int rand1 = rand() % this->order.size();
-    int rand2 = rand() % this->order.size();
-    while (rand2 == rand1) {
-        rand2 = rand() % this->order.size();
+    // Copies the island's state between generations (its random state,
+    // progress and current generation) to >out<.
+    void save(char *out) const {
+        uint64_t state[4];
+        this->rng.getState(state);
+        memcpy(out, state, sizeof(state));
+        out += sizeof(state);
+        memcpy(out, &this->progress, sizeof(IslandProgress));
+        this->population.save(out + sizeof(IslandProgress));
     }
 
-    assert(rand1 != rand2);
-    swap(order[rand1], order[rand2]);
-}
+    // Restores a state written by save(), for the same shape of island.
+    void restore(const char *in) {
+        uint64_t state[4];
+        memcpy(state, in, sizeof(state));
+        this->rng.setState(state);
+        in += sizeof(state);
+        memcpy(&this->progress, in, sizeof(IslandProgress));
+        this->population.load(in + sizeof(IslandProgress));
+    }
 
-/* ========== Nonmember Functions ========== */
+    // Other methods
 
-// Generate an offspring genome by crosslinking the order vectors of 
-// two existing genomes. We assume that these genomes are made of unique
-// elements.
-TSPGenome *crosslink(const TSPGenome &g1, const TSPGenome &g2) {
-    // Sizes should be equal (same circuit length)
-    vector<int> g1Order = g1.getOrder();
-    assert(g1Order.size() == g2.getOrder().size());
+    // Runs one generation: evaluate and rank, then (if asked) trade
+    // migrants with the neighbouring islands, then breed and mutate.
+    // Returns false, having only evaluated and ranked, if the run is over.
+    bool evolve(int gen, Mailbox<Index> *outbox, Mailbox<Index> *inbox) {
+        GenerationRecord record;
+        uint64_t allocationsBefore = allocationCount();
+        auto start = chrono::steady_clock::now();
 
-    unsigned int N = g1Order.size();
-    vector<int> offspring;
-    int offspringEnd = rand() % N;
+        this->evaluate();
+        record.evaluateSeconds = secondsSince(start);
 
-    // Don't make two calls to g1.getOrder() here to make sure iterators
-    // are consistent ****
-    std::copy(g1Order.begin(), g1Order.begin() + offspringEnd, 
-              std::back_inserter(offspring));
-    set<int> offspringSet(offspring.begin(), offspring.begin() + offspringEnd);
+        start = chrono::steady_clock::now();
+        this->rank();
+        if (this->getBestLength() < this->progress.bestSeen) {
+            this->progress.bestSeen = this->getBestLength();
+            this->progress.generationsWithoutImprovement = 0;
+        }
+        else {
+            this->progress.generationsWithoutImprovement++;
+        }
+        int stalled = this->progress.generationsWithoutImprovement;
+        if (this->controller->update(this->id, gen, this->getBestLength(),
+                                     stalled))
+            return false;
+        if (outbox)
+            this->emigrate(*outbox);
+        if (inbox)
+            this->immigrate(*inbox);
+        record.selectSeconds = secondsSince(start);
+
+        // Print stuff to see what's going on. No flush, as this runs in the
+        // middle of the hot loop; a terminal still sees each line.
+        if (this->options.verbose && gen % 10 == 0) {
+            cout << "Generation " << gen << ": shortest path is "
+                 << this->getBestLength() << "\n";
+        }
 
-    for (int num : g2.getOrder()) {
-        if (!offspringSet.count(num)) {
-            // If num is not already included
-            offspring.push_back(num);
+        double diversity = -1;
+        if (this->options.telemetry) {
+            double sum = 0;
+            double worst = 0;
+            for (const RankedGenome &r : this->ranking) {
+                sum += r.length;
+                worst = std::max(worst, r.length);
+            }
+            record.island = this->id;
+            record.generation = gen;
+            record.bestLength = this->getBestLength();
+            record.meanLength = sum / this->populationSize;
+            record.worstLength = worst;
+            diversity = this->diversity();
+            record.diversity = diversity;
         }
-    }
 
-    assert(offspring.size() == N);
-    return new TSPGenome(offspring);
-}
+        if (this->options.adaptive && gen % ADAPT_INTERVAL == 0) {
+            if (diversity < 0)
+                diversity = this->diversity();
+            this->adapt(diversity);
+        }
 
+        start = chrono::steady_clock::now();
+
+        // Keep the fittest genomes, and replace our "unfit" members by
+        // breeding the "fit" members.
+        for (int i = 0; i < this->keepPopulation; ++i)
+            this->population.carryOver(this->ranking[i].index, i);
+
+        for (int i = this->keepPopulation; i < this->populationSize; ++i) {
+            int fit1 = selectParent(this->options.selection, this->ranking,
+                                    this->keepPopulation,
+                                    this->options.tournamentSize, -1,
+                                    this->rng);
+            int fit2 = selectParent(this->options.selection, this->ranking,
+                                    this->keepPopulation,
+                                    this->options.tournamentSize, fit1,
+                                    this->rng);
+
+            GenomeView<Index> next = this->population.nextGenome(i);
+            Index *child = next.order;
+            if (this->progress.crossoverRate >= 1 ||
+                this->rng.uniform() < this->progress.crossoverRate) {
+                *next.valid = 0;
+                crossover(this->options.crossover,
+                          this->population.getOrder(this->ranking[fit1].index),
+                          this->population.getOrder(this->ranking[fit2].index),
+                          child, this->numCities, this->scratch, this->rng);
+            }
+            else {
+                // Crossing near-identical parents mostly gives back one of
+                // them, so copy a parent and reverse a stretch of it.
+                this->population.carryOver(this->ranking[fit1].index, i);
+                invertGenome(next, this->numCities, this->dist, this->rng);
+            }
+            if (this->options.localSearch) {
+                std::copy(child, child + this->numCities, this->tour.begin());
+                improveTour(this->tour, this->dist, *this->neighbours,
+                            LocalSearchOptions(), this->localSearch);
+                std::copy(this->tour.begin(), this->tour.end(), child);
+                *next.valid = 0;
+            }
+        }
+        this->population.swapBuffers();
+        record.breedSeconds = secondsSince(start);
 
-// Returns true if g1 has a shorter circuit length than g2, false otherwise.
-bool isShorterPath(const TSPGenome *g1, const TSPGenome *g2) {
-    return g1->getCircuitLength() < g2->getCircuitLength();
-}
+        // Mutate the population
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < this->progress.mutationCount; ++i) {
+            // Don't mutate the best solution
+            int randI = 1 + this->rng.below(this->populationSize - 1);
+            mutateGenome(this->population.genome(randI), this->numCities,
+                         this->dist, this->rng);
+        }
+        record.mutateSeconds = secondsSince(start);
+
+        if (this->options.telemetry) {
+            record.allocations = allocationCount() - allocationsBefore;
+            this->options.telemetry->record(record);
+        }
+        return true;
+    }
 
+    // Evaluates the final generation so getBest sees all of it.
+    void finish() {
+        this->evaluate();
+        this->rank();
+    }
 
-// Finds a short path (not shortest).
-TSPGenome *findAShortPath(const vector<Point> &points,
-                           int populationSize, int numGenerations,
-                           int keepPopulation, int numMutations) {
-    assert(populationSize > 0);
+    // Posts copies of the best genomes (at most the keepPopulation elites)
+    // to >box<, once the receiver has collected the previous ones. Gives
+    // up if the run stops in the meantime, as the receiver may be gone.
+    void emigrate(Mailbox<Index> &box) {
+        while (box.full.load(memory_order_acquire)) {
+            if (this->controller->isStopping())
+                return;
+            this_thread::yield();
+        }
 
-    // Generate an initial population of random genomes. Use array of pointers
-    // so we can easily update the lengths (g->computeCircuitLength())
-    vector<TSPGenome *> genomes(populationSize);
-    for (int i = 0; i < populationSize; ++i) {
-        genomes[i] = new TSPGenome(points.size());
+        int count = std::min(this->options.numMigrants,
+                             (int) box.lengths.size());
+        count = std::min(count, std::max(this->keepPopulation, 1));
+        for (int k = 0; k < count; k++) {
+            const Index *order =
+                this->population.getOrder(this->ranking[k].index);
+            std::copy(order, order + this->numCities,
+                      &box.orders[(size_t) k * this->numCities]);
+            box.lengths[k] = this->ranking[k].length;
+        }
+        box.count = count;
+        box.full.store(true, memory_order_release);
     }
 
-    for (int gen = 0; gen < numGenerations; ++gen) {
-        // Compute circuit length for each genome
-        for (TSPGenome *g : genomes) {
-            g->computeCircuitLength(points);
+    // Replaces the least fit genomes with the migrants posted to >box<,
+    // waiting for them if need be (but, like emigrate, not once the run is
+    // stopping). The best genome is never replaced.
+    void immigrate(Mailbox<Index> &box) {
+        while (!box.full.load(memory_order_acquire)) {
+            if (this->controller->isStopping())
+                return;
+            this_thread::yield();
+        }
+
+        // Past the elites the ranking is in no order, so first move the
+        // longest tours to its end. It is ranked again afterwards.
+        int count = std::min(box.count, this->populationSize - 1);
+        std::nth_element(this->ranking.begin() + 1,
+                         this->ranking.end() - count, this->ranking.end(),
+                         [](const RankedGenome &a, const RankedGenome &b) {
+            return a.length < b.length;
+        });
+        for (int k = 0; k < count; k++) {
+            int slot = this->ranking[this->populationSize - 1 - k].index;
+            GenomeView<Index> g = this->population.genome(slot);
+            const Index *order = &box.orders[(size_t) k * this->numCities];
+            std::copy(order, order + this->numCities, g.order);
+            *g.length = box.lengths[k];
+            *g.valid = 1;
         }
+        box.full.store(false, memory_order_release);
+        this->rank();
+    }
+};
+
+
+/*
+ * Gives island >k< its own settings, when the options ask for varied
+ * islands. Island 0 keeps the ones given. Island k breeds with the k-th
+ * crossover operator after the given one, and mutates 1/2, 2, 1/4, 4, ...
+ * times as many genomes per generation for k = 1, 2, 3, 4, ..., but at
+ * least one (unless none were asked for) and at most populationSize (unless
+ * more were asked for).
+ */
+static void varyIsland(unsigned int k, int populationSize,
+                       GAOptions &options, int &numMutations) {
+    if (!options.varyIslands || k == 0)
+        return;
 
-        // Sort genomes by circuit length
-        std::sort(genomes.begin(), genomes.end(), isShorterPath);
+    const int NUM_CROSSOVERS = (int) Crossover::CYCLE + 1;
+    options.crossover =
+        (Crossover) (((int) options.crossover + k) % NUM_CROSSOVERS);
 
-        // Print stuff to see what's going on
-        if (gen % 10 == 0) {
-            cout << "Generation " << gen << ": shortest path is "
-                 << genomes[0]->getCircuitLength() << endl;
+    if (numMutations > 0) {
+        int shift = (k + 1) / 2;
+        double factor = ldexp(1.0, k % 2 ? -shift : shift);
+        double most = std::max(numMutations, populationSize);
+        double scaled = std::min(numMutations * factor, most);
+        numMutations = std::max((int) (scaled + 0.5), 1);
+    }
+}
+
+
+// Runs the genetic algorithm for one index width, on the distances in
+// >matrix<, or if that is null on those between >points<.
+template <typename Index>
+static TSPGenome *runGA(const vector<Point> &points,
+                        const DistanceMatrix *matrix,
+                        int populationSize, int numGenerations,
+                        int keepPopulation, int numMutations,
+                        const GAOptions &options) {
+    int numCities = matrix ? matrix->size() : points.size();
+    unsigned int numIslands = options.numIslands;
+    if (numIslands == 0)
+        numIslands = std::max(1u, thread::hardware_concurrency());
+
+    // Allocations are only counted for the telemetry.
+    if (options.telemetry)
+        countAllocations(true);
+
+    // The time limit counts from here, so it covers the setup too.
+    RunController controller(numIslands, options.timeLimit,
+                             options.targetLength, options.stallGenerations);
+
+    // Every genome is evaluated every generation, so compute the distances
+    // between points once up front, unless the caller already has. Large
+    // instances are the exception: their N^2 table would not fit, so
+    // distances are computed on the fly and the candidate lists stand in
+    // for the table wherever the GA looks for nearby cities.
+    DistanceMatrix *ownMatrix = nullptr;
+    if (!matrix) {
+        unsigned int maxCachedPoints = DEFAULT_MAX_CACHED_POINTS;
+        if (options.largeInstance)
+            maxCachedPoints = 0;
+        ownMatrix = new DistanceMatrix(points, MatrixLayout::FULL,
+                                       maxCachedPoints);
+        matrix = ownMatrix;
+    }
+    const DistanceMatrix &dist = *matrix;
+
+    // With local search on, every offspring is polished before it joins the
+    // population, which makes this a memetic algorithm. The construction
+    // heuristics need the same candidate lists.
+    NeighbourLists *neighbours = nullptr;
+    if (options.localSearch || options.seedFraction * populationSize >= 1) {
+        if (points.empty())
+            neighbours = new NeighbourLists(dist, options.numNeighbours);
+        else
+            neighbours = new NeighbourLists(points, options.numNeighbours,
+                                            options.numThreads);
+    }
+
+    // Island k draws from stream k of the run's seed, so a run is replayed
+    // exactly by running it again with the same seed.
+    Random seedStream(options.seed);
+    vector<Island<Index> *> islands;
+    int firstGeneration = 0;
+    ThreadPool *pool = nullptr;
+    if (numIslands == 1 && options.numThreads != 1)
+        pool = new ThreadPool(options.numThreads);
+    for (unsigned int k = 0; k < numIslands; k++) {
+        // Only the first island reports its progress.
+        GAOptions islandOptions = options;
+        islandOptions.verbose = options.verbose && k == 0;
+        int islandMutations = numMutations;
+        varyIsland(k, populationSize, islandOptions, islandMutations);
+        islands.push_back(new Island<Index>(points, dist, neighbours,
+                                            populationSize, keepPopulation,
+                                            islandMutations, islandOptions,
+                                            k, seedStream.nextStream(), pool,
+                                            &controller));
+    }
+
+    // The snapshot is the islands' blocks one after the other.
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.indexBytes = sizeof(Index);
+    header.numCities = numCities;
+    header.numIslands = numIslands;
+    header.populationSize = populationSize;
+    header.seed = options.seed;
+    size_t blockBytes = islands[0]->snapshotBytes();
+
+    bool ready = true;
+    if (options.resume) {
+        // Carry on from the snapshot, which must come from a run of the
+        // same shape.
+        SnapshotHeader saved;
+        vector<char> blocks;
+        ready = loadSnapshot(options.checkpointFile, saved, blocks) &&
+                  saved.indexBytes == header.indexBytes &&
+                  saved.numCities == header.numCities &&
+                  saved.numIslands == header.numIslands &&
+                  saved.populationSize == header.populationSize &&
+                  blocks.size() == blockBytes * numIslands;
+        if (ready) {
+            for (unsigned int k = 0; k < numIslands; k++)
+                islands[k]->restore(&blocks[blockBytes * k]);
+            firstGeneration = saved.generation;
         }
+    }
 
-        // Replace our "unfit" members by breeding the "fit" members. That is,
-        // use the top N genomes to replace the other genomes.
-        for (int i = keepPopulation; i < populationSize; ++i) {
-            int fit1 = rand() % keepPopulation;
-            int fit2 = rand() % keepPopulation;
-            while (fit2 == fit1) {
-                fit2 = rand() % keepPopulation;
+    Checkpointer *checkpointer = nullptr;
+    if (ready && !options.checkpointFile.empty() &&
+        options.checkpointInterval > 0)
+        checkpointer = new Checkpointer(options.checkpointFile, header,
+                                        blockBytes);
+
+    // Runs island k to the last generation, or until the controller stops
+    // the run, depositing its state with the checkpointer every
+    // checkpointInterval generations. Without boxes the island never
+    // migrates.
+    auto runIsland = [&](unsigned int k, Mailbox<Index> *outbox,
+                         Mailbox<Index> *inbox) {
+        Island<Index> *island = islands[k];
+        for (int gen = firstGeneration; gen < numGenerations; ++gen) {
+            bool migrate = outbox && options.numMigrants > 0 &&
+                           options.migrationInterval > 0 && gen > 0 &&
+                           gen % options.migrationInterval == 0;
+            bool going;
+            if (migrate)
+                going = island->evolve(gen, outbox, inbox);
+            else
+                going = island->evolve(gen, nullptr, nullptr);
+            if (!going)
+                break;
+
+            if (checkpointer && (gen + 1) % options.checkpointInterval == 0 &&
+                gen + 1 < numGenerations) {
+                char *block = checkpointer->beginDeposit(k, gen + 1);
+                if (block) {
+                    island->save(block);
+                    checkpointer->endDeposit();
+                }
             }
+        }
+
+        // Once the run stops, the snapshot being staged will never be
+        // complete, and no island should wait for it.
+        if (checkpointer && controller.isStopping())
+            checkpointer->cancel();
+        island->finish();
+    };
 
-            genomes[i] = crosslink(*genomes[fit1], *genomes[fit2]);
+    // With nothing to resume from, give up without running.
+    if (ready && numIslands == 1) {
+        runIsland(0, nullptr, nullptr);
+    }
+    else if (ready) {
+        // Island k posts its migrants to boxes[k], which island k + 1 reads
+        // on its next migration, so genomes travel around a ring. Each
+        // island only ever touches its two boxes, so an island only waits
+        // on its neighbours, and only at migrations. That needs every
+        // island to have a thread of its own.
+        vector<Mailbox<Index>> boxes(numIslands);
+        for (Mailbox<Index> &box : boxes) {
+            box.orders.resize((size_t) options.numMigrants * numCities);
+            box.lengths.resize(options.numMigrants);
         }
 
-        // Mutate the population
-        for (int i = 0; i < numMutations; ++i) {
-            // Don't mutate the best solution
-            int randI = 1 + rand() % (populationSize - 1);
-            genomes[randI]->mutate();
+        ThreadPool islandPool(numIslands);
+        for (unsigned int k = 0; k < numIslands; k++) {
+            Mailbox<Index> *outbox = &boxes[k];
+            Mailbox<Index> *inbox = &boxes[(k + numIslands - 1) % numIslands];
+            islandPool.submit([=, &runIsland]() {
+                runIsland(k, outbox, inbox);
+            });
         }
+        islandPool.wait();
+    }
+
+    if (ready && options.verbose &&
+        controller.getReason() != StopReason::FINISHED) {
+        cout << "Stopped at generation " << controller.getStopGeneration()
+             << " after " << controller.elapsedSeconds() << " s: "
+             << stopReasonName(controller.getReason()) << endl;
+    }
+
+    // Take the best genome of the last generation over all islands.
+    TSPGenome *result = nullptr;
+    if (ready) {
+        Island<Index> *best = islands[0];
+        for (Island<Index> *island : islands) {
+            if (island->getBestLength() < best->getBestLength())
+                best = island;
+        }
+        const Index *order = best->getBest();
+        result = new TSPGenome(vector<int>(order, order + numCities));
+        result->computeCircuitLength(dist);
     }
 
     // Free memory
-    for (unsigned int i = 1; i < genomes.size(); i++)
-        delete genomes[i];
+    delete checkpointer;
+    for (Island<Index> *island : islands)
+        delete island;
+    delete pool;
+    delete neighbours;
+    delete ownMatrix;
+    if (options.telemetry)
+        countAllocations(false);
+
+    return result;
+}
+
+
+// Finds a short path (not shortest). Returns null only when asked to resume
+// from a snapshot that is missing or was taken of a different run shape.
+TSPGenome *findAShortPath(const vector<Point> &points,
+                           int populationSize, int numGenerations,
+                           int keepPopulation, int numMutations,
+                           const GAOptions &options) {
+    assert(populationSize > 0);
+
+    // Genomes are stored with the narrowest index type that fits.
+    if (points.size() <= 65536)
+        return runGA<uint16_t>(points, nullptr, populationSize,
+                               numGenerations, keepPopulation, numMutations,
+                               options);
+    return runGA<uint32_t>(points, nullptr, populationSize, numGenerations,
+                           keepPopulation, numMutations, options);
+}
+
+
+// Same, for cities known only by the distances in >dist<, such as TSPLIB
+// GEO and EXPLICIT instances. Without coordinates, the space-filling curve
+// construction falls back to nearest neighbour tours, and the candidate
+// lists are found by scanning the matrix.
+TSPGenome *findAShortPath(const DistanceMatrix &dist,
+                           int populationSize, int numGenerations,
+                           int keepPopulation, int numMutations,
+                           const GAOptions &options) {
+    assert(populationSize > 0);
 
-    return genomes[0];
+    vector<Point> noPoints;
+    if (dist.size() <= 65536)
+        return runGA<uint16_t>(noPoints, &dist, populationSize,
+                               numGenerations, keepPopulation, numMutations,
+                               options);
+    return runGA<uint32_t>(noPoints, &dist, populationSize, numGenerations,
+                           keepPopulation, numMutations, options);
 }
@@ -1,38 +1,72 @@
-#include "Point.hh"
+#include "DistanceMatrix.hh"
+#include "TSPGenome.hh"
+#include "construct.hh"
+#include "crossover.hh"
+#include "local-search.hh"
+#include "selection.hh"
+#include "telemetry.hh"
+#include <string>
 #include <vector> 
 using namespace std;
 
-// Represents on possible solution to a Traveling Salesman Problem. Used 
-// to solve TSP with genetic algorithms.
-class TSPGenome {
+// Optional settings for findAShortPath. The defaults reproduce the
+// original behaviour.
+struct GAOptions {
+    bool verbose = true;    // print the best length every 10 generations
+    bool localSearch = false;   // polish offspring with 2-opt and Or-opt
+    int numNeighbours = 8;      // candidate list size for the local search
+    double seedFraction = 0;    // share of generation 0 built by heuristics
+    bool largeInstance = false; // never tabulate distances, however few
+    unsigned int numThreads = 1;    // threads for evaluation (0 = all),
+                                    // with a single island only
+    Crossover crossover = Crossover::CROSSLINK;
+    Selection selection = Selection::TRUNCATION;
+    int tournamentSize = 3;
+    uint64_t seed = 0;          // the same seed replays the same run
+    TelemetrySink *telemetry = nullptr; // gets a record per generation
 
-private:
-    vector<int> order;
-    double circuitLength;
-    static const int DUMMY_LENGTH = 1e9;
+    // Checkpointing: every checkpointInterval generations (0 = never) the
+    // whole GA state is saved to checkpointFile. With resume, the run
+    // carries on from the snapshot in checkpointFile instead of starting
+    // afresh; it must be run with the same shape (cities, islands and
+    // population size).
+    string checkpointFile;
+    int checkpointInterval = 0;
+    bool resume = false;
 
-public:
-    // Constructors 
-    TSPGenome() {}
-    TSPGenome(int numPoints);
-    TSPGenome(const vector<int> &order);
-          
+    // Run control: the run ends early once timeLimit seconds have passed,
+    // once a tour of at most targetLength is found, or once every island
+    // has gone stallGenerations generations without improving (see
+    // RunController). Zero turns a criterion off.
+    double timeLimit = 0;
+    double targetLength = 0;
+    int stallGenerations = 0;
 
-    // Destructor 
-    ~TSPGenome() {}
+    // Adaptive operators: each island watches its diversity and, as it
+    // converges, mutates more genomes per generation and breeds more of
+    // its offspring by reversing a stretch of one parent instead of by
+    // crossover, easing back to the settings above as diversity returns.
+    bool adaptive = false;
 
-    // Accessor methods 
-    vector<int> getOrder() const;
-    double getCircuitLength() const;
-
-    // Other methods 
-    void computeCircuitLength(const vector<Point> &points);
-    void mutate();
+    // Island model: this many populations of populationSize genomes each
+    // evolve side by side, one per thread (0 = one per hardware thread),
+    // and every migrationInterval generations each sends copies of its
+    // numMigrants best genomes to the next island on a ring. With
+    // varyIslands, the islands after the first also breed with other
+    // crossover operators and mutate at other rates, so the ring mixes
+    // several search strategies (see varyIsland in tsp-ga.cc).
+    unsigned int numIslands = 1;
+    int migrationInterval = 50;
+    int numMigrants = 2;
+    bool varyIslands = true;
 };
 
 // Other functions
-TSPGenome *crosslink(const TSPGenome &g1, const TSPGenome &g2);
-bool isShorterPath(const TSPGenome *g1, const TSPGenome *g2);
 TSPGenome *findAShortPath(const vector<Point> &points,
                            int populationSize, int numGenerations,
-                           int keepPopulation, int numMutations);
+                           int keepPopulation, int numMutations,
+                           const GAOptions &options = GAOptions());
+TSPGenome *findAShortPath(const DistanceMatrix &dist,
+                           int populationSize, int numGenerations,
+                           int keepPopulation, int numMutations,
+                           const GAOptions &options = GAOptions());
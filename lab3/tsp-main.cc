@@ -1,13 +1,42 @@
 #include "tsp-ga.hh"
+#include "aco.hh"
+#include "anneal.hh"
+#include "batch.hh"
+#include "loader.hh"
+#include "tsplib.hh"
 #include <ctime>
 #include <cstdlib>
 #include <iostream>
+#include <string>
 using namespace std;
 
+// Which solver runs.
+enum class Engine {
+    GENETIC,
+    ANNEALING,
+    ANT_COLONY
+};
+
+void usage() {
+    cout << "usage: ./tsp-ga population generations keep mutate "
+         << "[--threads N] [--local-search] [--seed-fraction F] "
+         << "[--crossover crosslink|ox|pmx|cx] "
+         << "[--selection truncation|tournament|rank] [--tournament-size T] "
+         << "[--islands N [--same-islands]] [--migrate-every M] "
+         << "[--migrants K] [--seed S] "
+         << "[--telemetry file.csv|file.jsonl] "
+         << "[--checkpoint file [--checkpoint-every N] [--resume]] "
+         << "[--time-limit S] [--target L] [--stall N] [--adaptive] "
+         << "[--engine ga|sa|aco [--moves M] [--restarts R] "
+         << "[--cooling geometric|linear|lundy-mees]] "
+         << "[--large] [--input file|file.tsp [--tour file.tour]] "
+         << "[--batch file-or-dir ...]" << endl;
+    exit(1);
+}
+
 int main(int argc, char *argv[]) {
-    if (argc != 5) {
-        cout << "usage: ./tsp-ga population generations keep mutate" << endl;
-        exit(1);
+    if (argc < 5) {
+        usage();
     }
 
     // Assume args are numbers
@@ -16,6 +45,123 @@ int main(int argc, char *argv[]) {
     float keep = atof(argv[3]);
     float mutate = atof(argv[4]);
 
+    GAOptions options;
+    SAOptions annealOptions;
+    ACOOptions colonyOptions;
+    Engine engine = Engine::GENETIC;
+    long long numMoves = 0;
+    bool seeded = false;
+    string telemetryFile;
+    string tourFile;
+    bool seedFractionGiven = false;
+    unsigned int numThreads = 0;
+    string inputFile;
+    vector<string> batchPaths;
+    bool batch = false;
+    for (int i = 5; i < argc; i++) {
+        string arg = argv[i];
+        if (batch && arg.compare(0, 2, "--") != 0)
+            batchPaths.push_back(arg);
+        else if (arg == "--batch")
+            batch = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            numThreads = atoi(argv[++i]);
+        else if (arg == "--local-search")
+            options.localSearch = true;
+        else if (arg == "--seed-fraction" && i + 1 < argc) {
+            options.seedFraction = atof(argv[++i]);
+            seedFractionGiven = true;
+        }
+        else if (arg == "--large")
+            options.largeInstance = true;
+        else if (arg == "--tour" && i + 1 < argc)
+            tourFile = argv[++i];
+        else if (arg == "--crossover" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name == "crosslink")
+                options.crossover = Crossover::CROSSLINK;
+            else if (name == "ox")
+                options.crossover = Crossover::ORDER;
+            else if (name == "pmx")
+                options.crossover = Crossover::PARTIALLY_MAPPED;
+            else if (name == "cx")
+                options.crossover = Crossover::CYCLE;
+            else
+                usage();
+        }
+        else if (arg == "--selection" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name == "truncation")
+                options.selection = Selection::TRUNCATION;
+            else if (name == "tournament")
+                options.selection = Selection::TOURNAMENT;
+            else if (name == "rank")
+                options.selection = Selection::RANK;
+            else
+                usage();
+        }
+        else if (arg == "--tournament-size" && i + 1 < argc)
+            options.tournamentSize = atoi(argv[++i]);
+        else if (arg == "--islands" && i + 1 < argc)
+            options.numIslands = atoi(argv[++i]);
+        else if (arg == "--same-islands")
+            options.varyIslands = false;
+        else if (arg == "--migrate-every" && i + 1 < argc)
+            options.migrationInterval = atoi(argv[++i]);
+        else if (arg == "--migrants" && i + 1 < argc)
+            options.numMigrants = atoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        }
+        else if (arg == "--telemetry" && i + 1 < argc)
+            telemetryFile = argv[++i];
+        else if (arg == "--checkpoint" && i + 1 < argc)
+            options.checkpointFile = argv[++i];
+        else if (arg == "--checkpoint-every" && i + 1 < argc)
+            options.checkpointInterval = atoi(argv[++i]);
+        else if (arg == "--resume")
+            options.resume = true;
+        else if (arg == "--time-limit" && i + 1 < argc)
+            options.timeLimit = atof(argv[++i]);
+        else if (arg == "--target" && i + 1 < argc)
+            options.targetLength = atof(argv[++i]);
+        else if (arg == "--stall" && i + 1 < argc)
+            options.stallGenerations = atoi(argv[++i]);
+        else if (arg == "--adaptive")
+            options.adaptive = true;
+        else if (arg == "--engine" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name == "ga")
+                engine = Engine::GENETIC;
+            else if (name == "sa")
+                engine = Engine::ANNEALING;
+            else if (name == "aco")
+                engine = Engine::ANT_COLONY;
+            else
+                usage();
+        }
+        else if (arg == "--moves" && i + 1 < argc)
+            numMoves = atoll(argv[++i]);
+        else if (arg == "--restarts" && i + 1 < argc)
+            annealOptions.numRestarts = atoi(argv[++i]);
+        else if (arg == "--cooling" && i + 1 < argc) {
+            string name = argv[++i];
+            if (name == "geometric")
+                annealOptions.cooling = Cooling::GEOMETRIC;
+            else if (name == "linear")
+                annealOptions.cooling = Cooling::LINEAR;
+            else if (name == "lundy-mees")
+                annealOptions.cooling = Cooling::LUNDY_MEES;
+            else
+                usage();
+        }
+        else if (arg == "--input" && i + 1 < argc)
+            inputFile = argv[++i];
+        else
+            usage();
+    }
+
     // Error checking on inputs
     if (population <= 0 || generations <= 0) {
         cout << "input error: population = " << population << " or "
@@ -27,40 +173,267 @@ int main(int argc, char *argv[]) {
             << endl;
         exit(1);
     }
+    if (engine == Engine::GENETIC && population < 2) {
+        cout << "input error: population = " << population << " is < 2; "
+             << "crossover needs two parents" << endl;
+        exit(1);
+    }
+    if (engine == Engine::GENETIC &&
+        options.selection != Selection::TOURNAMENT &&
+        (int) (keep * population) < 2) {
+        cout << "input error: keep * population = "
+             << (int) (keep * population) << " is < 2; truncation and "
+             << "rank selection pick both parents among the kept genomes"
+             << endl;
+        exit(1);
+    }
     if (mutate < 0) {
         cout << "input error: mutate = " << mutate << " is negative" << endl;
         exit(1);
     }
+    if (options.seedFraction < 0 || options.seedFraction > 1) {
+        cout << "input error: seed fraction = " << options.seedFraction
+             << " is not in range [0,1]" << endl;
+        exit(1);
+    }
+    if (options.tournamentSize <= 0) {
+        cout << "input error: tournament size = " << options.tournamentSize
+             << " is <= 0" << endl;
+        exit(1);
+    }
+    if (options.migrationInterval <= 0 || options.numMigrants < 0) {
+        cout << "input error: migrate-every = " << options.migrationInterval
+             << " is <= 0 or migrants = " << options.numMigrants
+             << " is negative" << endl;
+        exit(1);
+    }
+
+    if (options.timeLimit < 0 || options.targetLength < 0 ||
+        options.stallGenerations < 0) {
+        cout << "input error: time-limit = " << options.timeLimit
+             << ", target = " << options.targetLength << " or stall = "
+             << options.stallGenerations << " is negative" << endl;
+        exit(1);
+    }
+
+    if (options.checkpointFile.empty() &&
+        (options.resume || options.checkpointInterval != 0)) {
+        cout << "input error: --resume and --checkpoint-every need "
+             << "--checkpoint" << endl;
+        exit(1);
+    }
+    if (!options.checkpointFile.empty() && options.checkpointInterval == 0)
+        options.checkpointInterval = 100;
+    if (options.checkpointInterval < 0) {
+        cout << "input error: checkpoint-every = "
+             << options.checkpointInterval << " is negative" << endl;
+        exit(1);
+    }
+
+    // Large instances start from constructed tours; random ones on 100k
+    // cities are hopelessly far from anything useful.
+    if (options.largeInstance && !seedFractionGiven)
+        options.seedFraction = 1;
+
+    // Without --seed every run differs; the seed is printed so a run can
+    // still be replayed. All randomness comes from Random streams of it.
+    if (!seeded)
+        options.seed = time(nullptr);
+
+    // The annealer and the ant colony share the seed, thread count and
+    // instance size of the GA settings. Without --moves the annealer gets
+    // about the work of the GA run given: population * generations tours
+    // evaluated at O(n) each, where an annealing move costs O(1). The
+    // colony runs population ants for generations iterations.
+    annealOptions.seed = options.seed;
+    annealOptions.numThreads = numThreads;
+    annealOptions.largeInstance = options.largeInstance;
+    colonyOptions.seed = options.seed;
+    colonyOptions.numThreads = numThreads;
+    colonyOptions.largeInstance = options.largeInstance;
+    if (engine != Engine::GENETIC &&
+        (!telemetryFile.empty() || !options.checkpointFile.empty())) {
+        cout << "input error: --telemetry and --checkpoint only apply to "
+             << "--engine ga" << endl;
+        exit(1);
+    }
+    if (engine == Engine::ANNEALING) {
+        if (numMoves < 0 || annealOptions.numRestarts == 0) {
+            cout << "input error: moves = " << numMoves << " is negative "
+                 << "or restarts = " << annealOptions.numRestarts
+                 << " is 0" << endl;
+            exit(1);
+        }
+    }
+
+    // GEO and EXPLICIT TSPLIB instances are solved on a table of their own
+    // distances, set below; everything else on the points.
+    DistanceMatrix *matrix = nullptr;
+    auto solve = [&](const vector<Point> &points) {
+        size_t numCities = matrix ? matrix->size() : points.size();
+        switch (engine) {
+        case Engine::ANNEALING: {
+            long long moves = numMoves;
+            if (moves == 0)
+                moves = (long long) population * generations * numCities;
+            if (matrix)
+                return annealAShortPath(*matrix, moves, annealOptions);
+            return annealAShortPath(points, moves, annealOptions);
+        }
+        case Engine::ANT_COLONY:
+            if (matrix)
+                return colonyAShortPath(*matrix, population, generations,
+                                        colonyOptions);
+            return colonyAShortPath(points, population, generations,
+                                    colonyOptions);
+        default:
+            if (matrix)
+                return findAShortPath(*matrix, population, generations,
+                                      (int) (keep * population),
+                                      (int) (mutate * population), options);
+            return findAShortPath(points, population, generations,
+                                  (int) (keep * population),
+                                  (int) (mutate * population), options);
+        }
+    };
+
+    if (batch) {
+        if (batchPaths.empty())
+            usage();
+        if (!telemetryFile.empty() || !options.checkpointFile.empty()) {
+            cout << "input error: --telemetry and --checkpoint do not apply "
+                 << "to --batch" << endl;
+            exit(1);
+        }
 
-    // Seed rng
-    srand(time(nullptr));
-    unsigned int num_points;
-    cout << "How many points? ";
-    cin >> num_points;
+        // Instances run side by side, so keep the per-run output quiet and
+        // give each run a single thread; --threads sizes the batch pool.
+        options.verbose = false;
+        options.numThreads = 1;
+        annealOptions.verbose = false;
+        annealOptions.numThreads = 1;
+        colonyOptions.verbose = false;
+        colonyOptions.numThreads = 1;
+        InstanceSolver solveOne = [&](const vector<Point> &points,
+                                      vector<int> &order) {
+            TSPGenome *g = solve(points);
+            order = g->getOrder();
+            double length = g->getCircuitLength();
+            delete g;
+            return length;
+        };
 
-    vector<Point> points(num_points);
-    double x, y, z;
-    for (unsigned int i = 0; i < num_points; i++) {
-        cout << "Point " << i << ": ";
-        cin >> x >> y >> z;
-        Point p(x, y, z);
-        points[i] = p;
+        vector<string> files = listInstanceFiles(batchPaths);
+        vector<BatchResult> results = runBatch(files, solveOne, numThreads);
+        for (const BatchResult &result : results)
+            printBatchResult(cout, result);
+        cout.flush();
+        return 0;
     }
 
-    TSPGenome *g = findAShortPath(points, population, generations,
-                                              (int) (keep * population),
-                                              (int) (mutate * population));
+    vector<Point> points;
+    TSPLibInstance instance;
+    bool tsplib = inputFile.size() >= 4 &&
+        inputFile.compare(inputFile.size() - 4, 4, ".tsp") == 0;
+    if (tsplib) {
+        if (!readTSPLib(inputFile, instance)) {
+            cout << "input error: cannot read a TSPLIB instance from "
+                 << inputFile << endl;
+            exit(1);
+        }
+        if (!tsplibPoints(instance, points)) {
+            if (instance.dimension > (int) DEFAULT_MAX_CACHED_POINTS) {
+                cout << "input error: " << inputFile << " has "
+                     << instance.dimension << " nodes; GEO and EXPLICIT "
+                     << "instances of more than " << DEFAULT_MAX_CACHED_POINTS
+                     << " are not supported" << endl;
+                exit(1);
+            }
+            matrix = new DistanceMatrix(tsplibMatrix(instance));
+        }
+    }
+    else if (!inputFile.empty()) {
+        // Text or binary point file, no prompts.
+        if (!loadPoints(inputFile, points)) {
+            cout << "input error: cannot read points from " << inputFile
+                 << endl;
+            exit(1);
+        }
+    }
+    else {
+        unsigned int num_points;
+        cout << "How many points? ";
+        cin >> num_points;
+
+        points.resize(num_points);
+        double x, y, z;
+        for (unsigned int i = 0; i < num_points; i++) {
+            cout << "Point " << i << ": ";
+            cin >> x >> y >> z;
+            Point p(x, y, z);
+            points[i] = p;
+        }
+    }
+
+    // Per-generation records go to a .csv file as CSV, anything else as
+    // JSON lines.
+    FileTelemetry *telemetry = nullptr;
+    if (!telemetryFile.empty()) {
+        bool csv = telemetryFile.size() >= 4 &&
+            telemetryFile.compare(telemetryFile.size() - 4, 4, ".csv") == 0;
+        telemetry = new FileTelemetry(telemetryFile, csv ?
+                                      TelemetryFormat::CSV :
+                                      TelemetryFormat::JSON_LINES);
+        if (!telemetry->isOpen()) {
+            cout << "input error: cannot write telemetry to "
+                 << telemetryFile << endl;
+            exit(1);
+        }
+        options.telemetry = telemetry;
+    }
+
+    // --threads applies to evaluating the population, to the restarts of
+    // the annealer or to the ants.
+    options.numThreads = numThreads;
+    TSPGenome *g = solve(points);
+    if (!g) {
+        cout << "input error: cannot resume from " << options.checkpointFile
+             << " (missing, or taken of a different run shape)" << endl;
+        exit(1);
+    }
     vector<int> shortestPath = g->getOrder();
     double shortestLength = g->getCircuitLength();
 
     cout << "Best order: [";
-    for (unsigned int i; i < shortestPath.size(); i++) {
+    for (unsigned int i = 0; i < shortestPath.size(); i++) {
         cout << shortestPath[i];
         if (i < shortestPath.size() - 1)
             cout << " ";
     }
     cout << "]" << endl;
     cout << "Shortest distance: " << shortestLength << endl;
+    if (tsplib) {
+        // Scored with the instance's own distance function, comparable
+        // with published TSPLIB results.
+        cout << "TSPLIB length: " << tsplibTourLength(instance, shortestPath)
+             << endl;
+        vector<int> reference;
+        if (!tourFile.empty()) {
+            // Only a tour of these very cities can be scored.
+            if (readTSPLibTour(tourFile, instance.dimension, reference)) {
+                cout << "Reference tour length: "
+                     << tsplibTourLength(instance, reference) << endl;
+            }
+            else {
+                cout << "Reference tour: " << tourFile << " is not a tour "
+                     << "of the " << instance.dimension << " cities"
+                     << endl;
+            }
+        }
+    }
+    cout << "Seed: " << options.seed << endl;
 
     delete g;
+    delete telemetry;
+    delete matrix;
 }
@@ -75,7 +75,7 @@ int main() {
     double shortestLength = circuitLength(points, shortestPath);
 
     cout << "Best order: [";
-    for (unsigned int i; i < shortestPath.size(); i++) {
+    for (unsigned int i = 0; i < shortestPath.size(); i++) {
         cout << shortestPath[i];
         if (i < shortestPath.size() - 1)
             cout << " ";
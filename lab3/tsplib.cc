@@ -0,0 +1,323 @@
+#include "tsplib.hh"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+using namespace std;
+
+
+/* ========== Parsing ========== */
+
+// Strips leading and trailing whitespace.
+static string trim(const string &s) {
+    size_t first = s.find_first_not_of(" \t\r");
+    if (first == string::npos)
+        return "";
+    size_t last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+// Splits a "KEY : VALUE" header line. Section lines have no value.
+static void splitHeader(const string &line, string &key, string &value) {
+    size_t colon = line.find(':');
+    if (colon == string::npos) {
+        key = trim(line);
+        value = "";
+    }
+    else {
+        key = trim(line.substr(0, colon));
+        value = trim(line.substr(colon + 1));
+    }
+}
+
+// Reads >n< coordinate lines ("id x y" or "id x y z") into >coords<. Node
+// ids must run from 1 to n, in any order, each once.
+static bool readCoords(istream &in, int n, int dims, vector<Point> &coords) {
+    coords.assign(n, Point());
+    vector<bool> seen(n, false);
+    for (int k = 0; k < n; k++) {
+        int id;
+        double x, y, z = 0;
+        if (!(in >> id >> x >> y) || (dims == 3 && !(in >> z)))
+            return false;
+        if (id < 1 || id > n || seen[id - 1])
+            return false;
+        seen[id - 1] = true;
+        coords[id - 1] = Point(x, y, z);
+    }
+    return true;
+}
+
+/*
+ * Reads an EDGE_WEIGHT_SECTION in one of the TSPLIB matrix layouts into a
+ * full symmetric n x n matrix. The ROW formats list each row's entries
+ * above (UPPER) or below (LOWER) the diagonal, with or without the
+ * diagonal itself.
+ */
+static bool readWeights(istream &in, int n, const string &format,
+                        vector<double> &weights) {
+    weights.assign((size_t) n * n, 0);
+    for (int i = 0; i < n; i++) {
+        int from, to;
+        if (format == "FULL_MATRIX") {
+            from = 0;
+            to = n;
+        }
+        else if (format == "UPPER_ROW") {
+            from = i + 1;
+            to = n;
+        }
+        else if (format == "UPPER_DIAG_ROW") {
+            from = i;
+            to = n;
+        }
+        else if (format == "LOWER_ROW") {
+            from = 0;
+            to = i;
+        }
+        else if (format == "LOWER_DIAG_ROW") {
+            from = 0;
+            to = i + 1;
+        }
+        else {
+            return false;
+        }
+
+        for (int j = from; j < to; j++) {
+            double w;
+            if (!(in >> w))
+                return false;
+            weights[(size_t) i * n + j] = w;
+            weights[(size_t) j * n + i] = w;
+        }
+    }
+    return true;
+}
+
+/*
+ * Reads a TSPLIB .tsp file. Only symmetric instances (TYPE: TSP) with one
+ * of the EdgeWeightType distances are accepted. Returns false if the file
+ * is missing or malformed, or uses anything else.
+ */
+bool readTSPLib(const string &file, TSPLibInstance &instance) {
+    ifstream in(file);
+    if (!in)
+        return false;
+
+    instance = TSPLibInstance();
+    instance.dimension = -1;
+    string typeName, weightType, weightFormat = "FULL_MATRIX";
+    bool haveCoords = false, haveWeights = false;
+
+    string line;
+    while (getline(in, line)) {
+        string key, value;
+        splitHeader(line, key, value);
+        if (key.empty())
+            continue;
+        if (key == "EOF")
+            break;
+
+        if (key == "NAME") {
+            instance.name = value;
+        }
+        else if (key == "TYPE") {
+            typeName = value;
+        }
+        else if (key == "DIMENSION") {
+            instance.dimension = atoi(value.c_str());
+        }
+        else if (key == "EDGE_WEIGHT_TYPE") {
+            weightType = value;
+        }
+        else if (key == "EDGE_WEIGHT_FORMAT") {
+            weightFormat = value;
+        }
+        else if (key == "NODE_COORD_SECTION" ||
+                 key == "DISPLAY_DATA_SECTION") {
+            int dims = weightType == "EUC_3D" ? 3 : 2;
+            if (instance.dimension <= 0 || haveCoords ||
+                !readCoords(in, instance.dimension, dims, instance.coords))
+                return false;
+            haveCoords = true;
+        }
+        else if (key == "EDGE_WEIGHT_SECTION") {
+            if (instance.dimension <= 0 ||
+                !readWeights(in, instance.dimension, weightFormat,
+                             instance.weights))
+                return false;
+            haveWeights = true;
+        }
+        // Anything else (COMMENT, NODE_COORD_TYPE, ...) is ignored.
+    }
+
+    if (typeName != "TSP" || instance.dimension <= 0)
+        return false;
+
+    if (weightType == "EUC_2D")
+        instance.type = EdgeWeightType::EUC_2D;
+    else if (weightType == "EUC_3D")
+        instance.type = EdgeWeightType::EUC_3D;
+    else if (weightType == "CEIL_2D")
+        instance.type = EdgeWeightType::CEIL_2D;
+    else if (weightType == "ATT")
+        instance.type = EdgeWeightType::ATT;
+    else if (weightType == "GEO")
+        instance.type = EdgeWeightType::GEO;
+    else if (weightType == "EXPLICIT")
+        instance.type = EdgeWeightType::EXPLICIT;
+    else
+        return false;
+
+    if (instance.type == EdgeWeightType::EXPLICIT)
+        return haveWeights;
+    return haveCoords;
+}
+
+/*
+ * Reads a TSPLIB .tour file for an instance of >dimension< nodes into a
+ * 0-based visit order. Returns false if the file is missing, or does not
+ * hold a tour that visits every node exactly once.
+ */
+bool readTSPLibTour(const string &file, int dimension, vector<int> &order) {
+    ifstream in(file);
+    if (!in)
+        return false;
+
+    order.clear();
+    vector<bool> seen(dimension, false);
+    string line;
+    while (getline(in, line)) {
+        string key, value;
+        splitHeader(line, key, value);
+        if (key != "TOUR_SECTION")
+            continue;
+
+        // Node ids up to the terminating -1.
+        int id;
+        while (in >> id && id != -1) {
+            if (id < 1 || id > dimension || seen[id - 1])
+                return false;
+            seen[id - 1] = true;
+            order.push_back(id - 1);
+        }
+        break;
+    }
+    return isTour(order, dimension);
+}
+
+
+// True if >order< visits each of the cities 0 to n - 1 exactly once.
+bool isTour(const vector<int> &order, int n) {
+    if ((int) order.size() != n)
+        return false;
+    vector<bool> seen(n, false);
+    for (int c : order) {
+        if (c < 0 || c >= n || seen[c])
+            return false;
+        seen[c] = true;
+    }
+    return true;
+}
+
+
+/* ========== Distances ========== */
+
+// Rounds to the nearest integer the way TSPLIB's nint does.
+static double nint(double x) {
+    return (int) (x + 0.5);
+}
+
+// Converts a TSPLIB GEO coordinate (DDD.MM, degrees and minutes) to
+// radians.
+static double geoRadians(double x) {
+    const double PI = 3.141592;
+    int deg = (int) x;
+    double min = x - deg;
+    return PI * (deg + 5.0 * min / 3.0) / 180.0;
+}
+
+/*
+ * Returns the TSPLIB distance between nodes i and j, exactly as the
+ * TSPLIB specification computes it, so tour lengths can be compared with
+ * the published optima.
+ */
+double tsplibDistance(const TSPLibInstance &instance, int i, int j) {
+    if (instance.type == EdgeWeightType::EXPLICIT)
+        return instance.weights[(size_t) i * instance.dimension + j];
+
+    const Point &a = instance.coords[i];
+    const Point &b = instance.coords[j];
+    double dx = a.getX() - b.getX();
+    double dy = a.getY() - b.getY();
+    double dz = a.getZ() - b.getZ();
+
+    switch (instance.type) {
+    case EdgeWeightType::EUC_2D:
+        return nint(sqrt(dx * dx + dy * dy));
+    case EdgeWeightType::EUC_3D:
+        return nint(sqrt(dx * dx + dy * dy + dz * dz));
+    case EdgeWeightType::CEIL_2D:
+        return ceil(sqrt(dx * dx + dy * dy));
+    case EdgeWeightType::ATT: {
+        double r = sqrt((dx * dx + dy * dy) / 10.0);
+        double t = nint(r);
+        return t < r ? t + 1 : t;
+    }
+    default: {
+        // GEO: x is the latitude and y the longitude.
+        const double RRR = 6378.388;
+        double lat1 = geoRadians(a.getX()), lon1 = geoRadians(a.getY());
+        double lat2 = geoRadians(b.getX()), lon2 = geoRadians(b.getY());
+        double q1 = cos(lon1 - lon2);
+        double q2 = cos(lat1 - lat2);
+        double q3 = cos(lat1 + lat2);
+        return (int) (RRR * acos(0.5 * ((1 + q1) * q2 - (1 - q1) * q3)) +
+                      1.0);
+    }
+    }
+}
+
+// Returns the TSPLIB length of the round trip visiting >order<.
+double tsplibTourLength(const TSPLibInstance &instance,
+                        const vector<int> &order) {
+    double length = 0;
+    for (unsigned int i = 0; i < order.size(); i++) {
+        int next;
+        if (i == order.size() - 1)
+            next = 0;
+        else
+            next = i + 1;
+
+        length += tsplibDistance(instance, order[i], order[next]);
+    }
+    return length;
+}
+
+/*
+ * Gives the points the solvers work on, for instances whose TSPLIB distance
+ * is Euclidean (up to rounding and, for ATT, a constant factor): their
+ * coordinates are used as they are, and the solvers measure them with
+ * Point::distanceTo. Returns false for GEO and EXPLICIT instances, which
+ * have to be solved on tsplibMatrix instead.
+ */
+bool tsplibPoints(const TSPLibInstance &instance, vector<Point> &points) {
+    if (instance.type == EdgeWeightType::GEO ||
+        instance.type == EdgeWeightType::EXPLICIT ||
+        instance.coords.empty())
+        return false;
+
+    points = instance.coords;
+    return true;
+}
+
+/*
+ * Tabulates tsplibDistance between every pair of nodes, so the solvers
+ * optimize under exactly the distances tours are scored by. This takes
+ * dimension^2 doubles, which is meant for the GEO and EXPLICIT instances:
+ * TSPLIB's are all small.
+ */
+DistanceMatrix tsplibMatrix(const TSPLibInstance &instance) {
+    return DistanceMatrix(instance.dimension, [&](size_t i, size_t j) {
+        return tsplibDistance(instance, i, j);
+    });
+}
@@ -0,0 +1,41 @@
+#ifndef TSPLIB_HH
+#define TSPLIB_HH
+
+#include "DistanceMatrix.hh"
+#include "Point.hh"
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// The TSPLIB distance functions this reader understands.
+enum class EdgeWeightType {
+    EUC_2D,         // Euclidean, rounded to the nearest integer
+    EUC_3D,
+    CEIL_2D,        // Euclidean, rounded up
+    ATT,            // pseudo-Euclidean (att48, att532)
+    GEO,            // great-circle distance, coordinates in DDD.MM
+    EXPLICIT        // distances listed in the file
+};
+
+// A symmetric TSPLIB instance (.tsp file).
+struct TSPLibInstance {
+    string name;
+    EdgeWeightType type;
+    int dimension;
+    vector<Point> coords;       // as given, or the display data for an
+                                // EXPLICIT instance; empty if there are none
+    vector<double> weights;     // dimension x dimension, EXPLICIT only
+};
+
+bool readTSPLib(const string &file, TSPLibInstance &instance);
+bool readTSPLibTour(const string &file, int dimension, vector<int> &order);
+bool isTour(const vector<int> &order, int n);
+double tsplibDistance(const TSPLibInstance &instance, int i, int j);
+double tsplibTourLength(const TSPLibInstance &instance,
+                        const vector<int> &order);
+bool tsplibPoints(const TSPLibInstance &instance, vector<Point> &points);
+DistanceMatrix tsplibMatrix(const TSPLibInstance &instance);
+
+
+#endif // TSPLIB_HH
@@ -0,0 +1,70 @@
+#include "Random.hh"
+using namespace std;
+
+
+// Seeds the generator by running >seed< through splitmix64, which spreads
+// even small or similar seeds over the whole state and never gives the
+// all-zero state xoshiro cannot leave.
+Random::Random(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        this->state[i] = z ^ (z >> 31);
+    }
+}
+
+
+void Random::getState(uint64_t out[4]) const {
+    for (int i = 0; i < 4; i++)
+        out[i] = this->state[i];
+}
+
+
+void Random::setState(const uint64_t in[4]) {
+    for (int i = 0; i < 4; i++)
+        this->state[i] = in[i];
+}
+
+
+// Advances the generator by 2^128 steps, as if that many numbers had been
+// drawn.
+void Random::jump() {
+    static const uint64_t JUMP[4] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (JUMP[i] & (1ULL << b)) {
+                for (int j = 0; j < 4; j++)
+                    s[j] ^= this->state[j];
+            }
+            (*this)();
+        }
+    }
+    this->setState(s);
+}
+
+
+// Returns a copy of this generator jumped k times: stream k of the
+// independent streams that start from this one. This costs k jumps, so to
+// make streams 0, 1, 2, ... in turn use nextStream instead.
+Random Random::stream(unsigned int k) const {
+    Random copy = *this;
+    for (unsigned int i = 0; i < k; i++)
+        copy.jump();
+    return copy;
+}
+
+
+// Returns a copy of this generator, then jumps this one. Called on a fresh
+// generator, the calls return streams 0, 1, 2, ... of it, one jump each.
+Random Random::nextStream() {
+    Random copy = *this;
+    this->jump();
+    return copy;
+}
@@ -0,0 +1,89 @@
+#ifndef RANDOM_HH
+#define RANDOM_HH
+
+#include <cstdint>
+using namespace std;
+
+
+// A fast random number generator (xoshiro256**, by Blackman and Vigna) with
+// a small state that can be copied, saved and replayed. The same seed
+// always gives the same sequence on every platform, unlike rand().
+//
+// Each thread should draw from its own generator. jump() advances one by
+// 2^128 steps, so copies of a generator jumped 0, 1, 2, ... times give
+// streams that never overlap; stream() makes such copies.
+//
+// It meets the standard UniformRandomBitGenerator requirements, so it can
+// also be passed to std::shuffle and the <random> distributions.
+class Random {
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    typedef uint64_t result_type;
+
+    // Constructors
+    Random(uint64_t seed = 0);
+
+    // Accessor methods
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    // The generator's whole state, for saving and restoring it.
+    void getState(uint64_t out[4]) const;
+    void setState(const uint64_t in[4]);
+
+    // Other methods
+
+    // Returns the next 64 random bits.
+    result_type operator()() {
+        uint64_t result = rotl(this->state[1] * 5, 7) * 9;
+        uint64_t t = this->state[1] << 17;
+
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+        this->state[2] ^= t;
+        this->state[3] = rotl(this->state[3], 45);
+
+        return result;
+    }
+
+    // Returns a uniform random integer in [0, bound), for bound > 0,
+    // without the bias of taking the remainder (Lemire's method).
+    uint32_t below(uint32_t bound) {
+        uint64_t m = ((*this)() >> 32) * bound;
+        uint32_t low = (uint32_t) m;
+        if (low < bound) {
+            uint32_t threshold = -bound % bound;
+            while (low < threshold) {
+                m = ((*this)() >> 32) * bound;
+                low = (uint32_t) m;
+            }
+        }
+        return (uint32_t) (m >> 32);
+    }
+
+    // Returns a uniform random double in [0, 1).
+    double uniform() {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    void jump();
+    Random stream(unsigned int k) const;
+    Random nextStream();
+};
+
+
+#endif // RANDOM_HH
@@ -1,13 +1,14 @@
 #include "maze.hh"
+#include "Random.hh"
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
-#include <ctime>
 #include <iostream>
+#include <string>
 #include <vector>
 using namespace std;
 
-Maze genMaze(int numRows, int numCols);
+Maze genMaze(int numRows, int numCols, Random &rng);
 void addDirectionOptions(const Maze &maze, const Location &current,
                          vector<Direction> &options);
 void addDirectionOption(const Maze &maze, const Location &current,
@@ -53,9 +54,10 @@ void addDirectionOption(const Maze &maze, const Location &current,
 }
 
 /*
- * Generates a maze of size numRows x numCols.
+ * Generates a maze of size numRows x numCols. The maze depends only on the
+ * state of >rng<, so the same seed always gives the same maze.
  */
-Maze genMaze(int numRows, int numCols) {
+Maze genMaze(int numRows, int numCols, Random &rng) {
     Maze maze(numRows, numCols);
     vector<Location> path;
 
@@ -88,7 +90,7 @@ Maze genMaze(int numRows, int numCols) {
 
         // Choose a random direction. Then, clear the wall in that direction
         // and move into the next cell.
-        int randIndex = rand() % options.size();
+        int randIndex = rng.below(options.size());
         Direction randDirection = options[randIndex];
         maze.clearWall(current.row, current.col, randDirection);
         Location nextLocation = maze.getNeighborCell(current.row, current.col,
@@ -101,14 +103,19 @@ Maze genMaze(int numRows, int numCols) {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        cout << "usage: ./numRows numCols" << endl;
+    if (argc != 3 && !(argc == 5 && string(argv[3]) == "--seed")) {
+        cout << "usage: ./numRows numCols [--seed S]" << endl;
         exit(1);
     }
 
     int numRows = atoi(argv[1]);
     int numCols = atoi(argv[2]);
 
+    // Seed 1 by default, so a plain run always gives the same maze.
+    uint64_t seed = 1;
+    if (argc == 5)
+        seed = strtoull(argv[4], nullptr, 10);
+
     if (numRows <= 0) {
         cout << "input error: numRows = " << numRows << " is <= 0" << endl;
         exit(1);
@@ -119,6 +126,7 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
-    Maze m = genMaze(numRows, numCols);
+    Random rng(seed);
+    Maze m = genMaze(numRows, numCols, rng);
     m.print(std::cout);
 }